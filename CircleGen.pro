@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -31,12 +31,59 @@ HEADERS += \
     inc/graphicsscene.hpp \
     inc/graphicsview.hpp \
     inc/monitor.hpp \
-    inc/mainwindow.hpp
+    inc/monitorchannel.hpp \
+    inc/mainwindow.hpp \
+    inc/jsonreader.hpp \
+    inc/treenode.hpp \
+    inc/treefile.hpp \
+    inc/treetask.hpp \
+    inc/treemap.hpp \
+    inc/treediff.hpp \
+    inc/console.hpp \
+    inc/geometry.hpp \
+    inc/verifier.hpp \
+    inc/simplifier.hpp \
+    inc/recorder.hpp \
+    inc/classifier.hpp \
+    inc/heatmap.hpp \
+    inc/quadtree.hpp \
+    inc/journal.hpp \
+    inc/solver.hpp \
+    inc/margins.hpp \
+    inc/codegen.hpp \
+    inc/treestats.hpp \
+    inc/earlyexit.hpp \
+    inc/thumbnails.hpp \
+    inc/trace.hpp \
+    inc/poster.hpp
 
 SOURCES += \
     src/graphicsscene.cpp \
     src/graphicsview.cpp \
     src/mainwindow.cpp \
+    src/monitorchannel.cpp \
+    src/jsonreader.cpp \
+    src/treefile.cpp \
+    src/treetask.cpp \
+    src/treemap.cpp \
+    src/treediff.cpp \
+    src/console.cpp \
+    src/geometry.cpp \
+    src/verifier.cpp \
+    src/simplifier.cpp \
+    src/recorder.cpp \
+    src/classifier.cpp \
+    src/heatmap.cpp \
+    src/quadtree.cpp \
+    src/journal.cpp \
+    src/solver.cpp \
+    src/margins.cpp \
+    src/codegen.cpp \
+    src/treestats.cpp \
+    src/earlyexit.cpp \
+    src/thumbnails.cpp \
+    src/trace.cpp \
+    src/poster.cpp \
     src/main.cpp
 
 FORMS += \
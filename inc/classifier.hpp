@@ -0,0 +1,49 @@
+#ifndef __INCLUDE_CLASSIFIER_H
+#define __INCLUDE_CLASSIFIER_H
+
+#include <treenode.hpp>
+#include <geometry.hpp>
+
+class QuadTree;
+
+//Результат прохода точки по дереву
+struct Outcome {
+	enum Kind { Outside, Covered, Failed, Open };
+
+	Kind _kind = Outside;
+	int _depth = 0;		//Число пройденных ответов
+	quint64 _path = 0;	//Ответы пути, первый ответ в старшем бите
+};
+
+//Классификация точек по дереву без участия сцены
+class Classifier {
+public:
+	Classifier(const Disk &base, const std::vector<qreal> &radius,
+	           std::shared_ptr<const TreeNode> root):
+	    _base(base), _radius(radius), _root(std::move(root)) {}
+
+	Outcome classify(const QPointF &point) const;
+
+	//Возвращает false, если точки прямоугольника расходятся по разным путям
+	bool classify(const QRectF &rect, Outcome &outcome) const;
+
+	//Ускоряющая структура должна соответствовать тому же дереву
+	void setQuadTree(std::shared_ptr<const QuadTree> quadTree) {
+		_quadTree = std::move(quadTree);
+	}
+
+	const std::vector<qreal>& getRadius() const { return _radius; }
+	const Disk& getBase() const { return _base; }
+	const std::shared_ptr<const TreeNode>& getRoot() const { return _root; }
+
+private:
+	template<class Answer>
+	bool walk(const Answer &answer, Outcome &outcome) const;
+
+	Disk _base;
+	std::vector<qreal> _radius;
+	std::shared_ptr<const TreeNode> _root;
+	std::shared_ptr<const QuadTree> _quadTree;
+};
+
+#endif //__INCLUDE_CLASSIFIER_H
@@ -0,0 +1,15 @@
+#ifndef __INCLUDE_CODEGEN_H
+#define __INCLUDE_CODEGEN_H
+
+#include <treefile.hpp>
+
+//Генерация заголовка C++ с деревом в виде constexpr-данных
+class CodeGen {
+public:
+	static bool write(QIODevice *device, const TreeDocument &doc,
+	                  const QString &space = "circlegen",
+	                  const TreeFile::Progress &progress = nullptr,
+	                  QString *error = nullptr);
+};
+
+#endif //__INCLUDE_CODEGEN_H
@@ -0,0 +1,29 @@
+#ifndef __INCLUDE_CONSOLE_H
+#define __INCLUDE_CONSOLE_H
+
+#include <QStringList>
+
+//Команды, выполняемые без главного окна
+class Console {
+public:
+	static bool accepts(int argc, char *argv[]);
+
+	static int exec(int argc, char *argv[]);
+
+private:
+	static int diff(const QStringList &args);
+
+	static int replay(const QStringList &args);
+
+	static int sweep(const QStringList &args);
+
+	static int exportCpp(const QStringList &args);
+
+	static int earlyExit(const QStringList &args);
+
+	static int corpus(const QStringList &args);
+
+	static int usage();
+};
+
+#endif //__INCLUDE_CONSOLE_H
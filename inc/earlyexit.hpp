@@ -0,0 +1,55 @@
+#ifndef __INCLUDE_EARLYEXIT_H
+#define __INCLUDE_EARLYEXIT_H
+
+#include <treenode.hpp>
+#include <geometry.hpp>
+#include <string>
+
+//Ранние выходы: если ячейка узла целиком помещается в последнюю
+//окружность, исход уже определен. Такой узел превращается в лист,
+//сразу ставящий последнюю окружность, и запрос заканчивается раньше
+class EarlyExit {
+public:
+	struct Exit {
+		std::string _path;	//Ответы от корня до узла
+		QPointF _center;	//Центр последней окружности
+	};
+
+	EarlyExit(const Disk &base, const std::vector<qreal> &radius):
+	    _base(base), _radius(radius) {}
+
+	//Узлы, исход которых определен; вложенные в них не перечисляются
+	std::vector<Exit> analyze(const TreeNode *root) const;
+
+	//Заменяет найденные узлы листьями; возвращает число удаленных узлов.
+	//Замена необратима: удаленные поддеревья не восстанавливаются
+	qint64 rewrite(TreeNode *root, const std::vector<Exit> &exits) const;
+
+	//Среднее число ответов для точки, равномерно распределенной в базовом круге
+	qreal expectedDepth(std::shared_ptr<const TreeNode> root) const;
+
+private:
+	struct Task {
+		const TreeNode *_node;
+		Cell _cell;
+		std::string _path;
+		std::vector<Exit> _exits;
+	};
+
+	bool fits(const Cell &cell, QPointF &center) const;
+	void collect(const TreeNode *node, Cell &cell, std::string &path,
+	             std::vector<Task> &tasks, std::vector<Exit> &exits) const;
+	void analyze(const TreeNode *node, Cell &cell, std::string &path,
+	             std::vector<Exit> &exits) const;
+
+	static qint64 size(const TreeNode *node);
+
+	static constexpr int SPLIT = 4;
+	static constexpr int COARSE = 12;	//Сетка быстрого отсева
+	static constexpr int GRID = 256;	//Сетка оценки средней глубины
+
+	Disk _base;
+	std::vector<qreal> _radius;
+};
+
+#endif //__INCLUDE_EARLYEXIT_H
@@ -0,0 +1,94 @@
+#ifndef __INCLUDE_GEOMETRY_H
+#define __INCLUDE_GEOMETRY_H
+
+#include <QPointF>
+#include <QRectF>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+struct Disk {
+	enum Relation { Outside, Inside, Crossing };
+
+	QPointF _center;
+	qreal _radius;
+
+	bool contains(const QPointF &point) const {
+		qreal dx = point.x() - _center.x();
+		qreal dy = point.y() - _center.y();
+		return dx * dx + dy * dy <= _radius * _radius;
+	}
+
+	QRectF bounds() const {
+		return QRectF(
+		    _center.x() - _radius, _center.y() - _radius,
+		    2 * _radius, 2 * _radius
+		);
+	}
+
+	//Точное положение прямоугольника относительно круга
+	Relation relate(const QRectF &rect) const {
+		qreal cx = _center.x(), cy = _center.y();
+		qreal nx = std::clamp(cx, rect.left(), rect.right()) - cx;
+		qreal ny = std::clamp(cy, rect.top(), rect.bottom()) - cy;
+		qreal rq = _radius * _radius;
+		if (nx * nx + ny * ny > rq) return Outside;
+		qreal fx = std::max(std::abs(cx - rect.left()), std::abs(cx - rect.right()));
+		qreal fy = std::max(std::abs(cy - rect.top()), std::abs(cy - rect.bottom()));
+		return (fx * fx + fy * fy <= rq)? Inside: Crossing;
+	}
+};
+
+//Точки пересечения окружностей (ноль, одна или две)
+std::vector<QPointF> intersect(const QPointF &c1, qreal r1, const QPointF &c2, qreal r2);
+
+//Сообщает о каждой паре пересекающихся окружностей. Окружности
+//перебираются по левому краю, так что сравниваются только пары
+//с перекрывающимися габаритами
+void intersectAll(const std::vector<Disk> &disks,
+                  const std::function<void(int, int, const std::vector<QPointF>&)> &report);
+
+//Минимальный охватывающий круг (алгоритм Вельцля без рекурсии)
+Disk enclose(std::vector<QPointF> points);
+
+//Ячейка дерева: часть базового круга, выделенная ответами на пути
+class Cell {
+public:
+	static constexpr int RESOLUTION = 48;
+
+	explicit Cell(const Disk &base);
+
+	void push(const Disk &disk, bool inside);
+	void pop();
+
+	bool contains(const QPointF &point) const;
+	//Точка в ячейке или не дальше epsilon от ее границы
+	bool contains(const QPointF &point, qreal epsilon) const;
+	const QRectF& bounds() const { return _bounds.back(); }
+	int depth() const { return _parts.size(); }
+
+	//Площадь оценивается по равномерной сетке внутри габарита
+	qreal area(int resolution = RESOLUTION) const;
+	std::vector<QPointF> samples(int resolution = RESOLUTION) const;
+	//Точная проверка по дугам границы и точкам их пересечения
+	bool isEmpty() const;
+	//Вся ячейка лежит в круге
+	bool isInside(const Disk &disk) const;
+
+	//Перебирает дуги границы: окружность и углы [from, to], from < to.
+	//Возвращает false, если перебор остановлен посетителем
+	bool arcs(const std::function<bool(const Disk&, qreal, qreal)> &visit) const;
+
+private:
+	struct Part {
+		Disk _disk;
+		bool _inside;
+	};
+
+	Disk _base;
+	std::vector<Part> _parts;
+	std::vector<QRectF> _bounds;
+};
+
+#endif //__INCLUDE_GEOMETRY_H
@@ -5,9 +5,18 @@
 #include <QGraphicsSceneWheelEvent>
 #include <QGraphicsScene>
 #include <QGraphicsPixmapItem>
+#include <QPainter>
 #include <QLabel>
 #include <QFile>
+#include <QTimer>
 #include "monitor.hpp"
+#include "treestats.hpp"
+#include "treenode.hpp"
+#include "geometry.hpp"
+#include "recorder.hpp"
+#include "journal.hpp"
+#include "heatmap.hpp"
+#include "quadtree.hpp"
 #include <cmath>
 #include <memory>
 #include <set>
@@ -28,7 +37,18 @@ public:
 	bool loadFromFile(QFile *file);
 	bool saveToFile(QFile *file) const;
 
+	TreeDocument getDocument() const;
+	void setDocument(TreeDocument doc);
+
 	void check(std::vector<std::string>& result) const;
+	TreeNode::Status verify(qreal *uncovered = nullptr) const;
+	qint64 simplify();
+	qint64 earlyExit(qreal *before = nullptr, qreal *after = nullptr);
+	qreal measure();
+	void weakest(std::vector<std::string>& result, int count) const;
+
+	Disk getBase() const;
+	std::vector<qreal> getRadius() const;
 
 	void setMonitor(Monitor *monitor) {
 		_monitor = monitor;
@@ -36,11 +56,49 @@ public:
 	Mode getMode() const { return _mode; }
 	void setMode(Mode mode);
 
+	std::shared_ptr<const TreeNode> getRoot() const { return _treeRoot; }
+	const std::string& getTextPath() const { return _textPath; }
+	int getLevels() const { return int(_circles.size()) - 1; }
+	const TreeStats& getStats() const { return _stats; }
+
+	void setRecorder(Recorder *recorder) {
+		_recorder = recorder;
+	}
+	Recorder* getRecorder() const { return _recorder; }
+
+	void setJournal(Journal *journal) {
+		_journal = journal;
+	}
+
+	bool isVisibleKnots() const { return _visibleKnots; }
+	bool isFilledArea() const { return _filledArea; }
+
+	//Текущий путь в дереве: ответы и положения окружностей от корня,
+	//включая еще не сохраненные узлы
+	std::string getNodePath() const { return _treeNode? nodePath(): std::string(); }
+	std::vector<QPointF> getPathCenters() const;
+	//Восстанавливает путь в режиме дерева
+	void restorePath(const std::string &path, const std::vector<QPointF> &centers);
+
 	void setVisibleKnots(bool visible) {
+		Recorder::Entry entry(_recorder, Recorder::Knots, visible);
 		_visibleKnots = visible;
 		updateKnots();
 	}
+	//revision - номер правки, по снимку которой построено разбиение
+	void setQuadTree(std::shared_ptr<const QuadTree> quadTree, quint64 revision);
+	void setHeatMap(bool visible);
+	void setHover(bool hover);
+	void setBatchRendering(bool batch);
+
+	//Неизменяемый снимок дерева; пересоздается после правок
+	std::shared_ptr<const Classifier> snapshot();
+	//Номер правки дерева; снимок дорог, номер дешев
+	quint64 getRevision() const { return _revision; }
+	void hover(const QPointF &point);
+	bool isHeatMap() const { return _heatItem; }
 	void setFilledArea(bool filled) {
+		Recorder::Entry entry(_recorder, Recorder::Fill, filled);
 		_filledArea = filled;
 		update();
 	}
@@ -53,7 +111,14 @@ public:
 	bool goToNext(bool ans);
 	bool goToInv();
 	bool goToPath(const std::string &path);
+	void grabCircle(int index, const QPointF &point);
+	void dragBy(const QPointF &off);
+	void releaseCircle();
+	void selectKnot(const QPointF &point);
+	void dropSelection();
+	void zoom(const QPointF &pos, qreal factor);
 	void savePath();
+	void flush();
 	void start();
 	void clear();
 	void reset();
@@ -76,41 +141,51 @@ private:
 
 		void update()
 		{
-			if (auto gs = dynamic_cast<GraphicsScene*>(scene())) {
-				const QPointF offset(_radius, _radius);
-				auto p1 = gs->pointToScene(_center - offset);
-				auto p2 = gs->pointToScene(_center + offset);
-				auto x1 = std::min(p1.x(), p2.x());
-				auto x2 = std::max(p1.x(), p2.x());
-				auto y1 = std::min(p1.y(), p2.y());
-				auto y2 = std::max(p1.y(), p2.y());
-				this->setRect(0, 0, x2 - x1, y2 - y1);
-				QColor hiddenColor = _filled? QColor(220, 220, 220) :
-				                              QColor(200, 200, 200);
-				if (_filled) {
-					QBrush brush; brush.setColor(hiddenColor);
-					brush.setStyle(Qt::SolidPattern);
-					setBrush(brush);
-					setZValue(-1.);
-				}
-				else {
-					setBrush(Qt::NoBrush);
-					setZValue(+1.);
-				}
+			if (!scene()) return;
+			auto *gs = static_cast<GraphicsScene*>(scene());
+			const QPointF offset(_radius, _radius);
+			auto p1 = gs->pointToScene(_center - offset);
+			auto p2 = gs->pointToScene(_center + offset);
+			auto x1 = std::min(p1.x(), p2.x());
+			auto x2 = std::max(p1.x(), p2.x());
+			auto y1 = std::min(p1.y(), p2.y());
+			auto y2 = std::max(p1.y(), p2.y());
+
+			//Геометрию и стиль задаем только при изменении
+			QRectF rect(0, 0, x2 - x1, y2 - y1);
+			bool moved = (rect != this->rect()) || (pos() != QPointF(x1, y1));
+			if (moved) {
+				setRect(rect);
 				setPos(QPointF(x1, y1));
-				QPen pen(
-				    _opaque? _colors[_index % _colors.size()]:
-				            hiddenColor
-				);
-				if (_index == 0) {
-					pen.setDashPattern({1,4});
-					pen.setWidth(3);
-				}
-				else {
-					pen.setWidth(5);
-				}
-				setPen(pen);
 			}
+			int style = _filled | (_opaque << 1);
+			if (moved || style != _style) gs->touchLayers();
+			if (style == _style) return;
+			_style = style;
+			QColor hiddenColor = _filled? QColor(220, 220, 220) :
+			                              QColor(200, 200, 200);
+			if (_filled) {
+				QBrush brush; brush.setColor(hiddenColor);
+				brush.setStyle(Qt::SolidPattern);
+				setBrush(brush);
+				setZValue(-1.);
+			}
+			else {
+				setBrush(Qt::NoBrush);
+				setZValue(+1.);
+			}
+			QPen pen(
+			    _opaque? _colors[_index % _colors.size()]:
+			            hiddenColor
+			);
+			if (_index == 0) {
+				pen.setDashPattern({1,4});
+				pen.setWidth(3);
+			}
+			else {
+				pen.setWidth(5);
+			}
+			setPen(pen);
 		}
 
 		virtual bool contains(const QPointF& point) const override
@@ -161,6 +236,7 @@ private:
 		qreal _radius;
 		bool _filled = false;
 		bool _opaque = true;
+		int _style = -1;
 		int _index;
 	};
 
@@ -172,11 +248,13 @@ private:
 
 		void update()
 		{
-			auto gs = dynamic_cast<GraphicsScene*>(scene());
-			if (!gs) return;
+			if (!scene()) return;
+			auto *gs = static_cast<GraphicsScene*>(scene());
 			auto p = gs->pointToScene(_point);
 			p -= QPointF(5, 5);
+			if (p == pos()) return;
 			setPos(p);
+			gs->touchLayers();
 		}
 
 		const QPointF& getPoint() const { return _point; }
@@ -190,19 +268,51 @@ private:
 		QPointF _point;
 	};
 
-	struct TreeNode {
-		std::array<std::shared_ptr<TreeNode>, 2> _branch;
-		CircleItem *_circle;
-		QPointF _center;
-		bool _fixed = false;
+	//Слой, рисующий все окружности и узлы за один вызов
+	struct LayerItem: public QGraphicsItem {
+
+		explicit LayerItem(bool front): _front(front) {
+			setZValue(front? 4.5: -1.5);
+			setAcceptedMouseButtons(Qt::NoButton);
+		}
+
+		virtual QRectF boundingRect() const override {
+			return scene()? scene()->sceneRect(): QRectF();
+		}
+
+		//Пустая форма не мешает выбору окружностей под курсором
+		virtual QPainterPath shape() const override { return QPainterPath(); }
+
+		virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem*, QWidget*) override {
+			if (scene()) static_cast<GraphicsScene*>(scene())->paintLayer(painter, _front);
+		}
+
+	private:
+		bool _front;
 	};
 
-	void convert(TreeNode *node, QJsonObject &object) const;
+	void paintLayer(QPainter *painter, bool front) const;
 
-	void parse(TreeNode *node, int index, const QJsonObject &object);
+	//Слои перерисовываются один раз за кадр, сколько бы элементов ни изменилось
+	void touchLayers() {
+		if (!_batch) return;
+		_back->update();
+		_front->update();
+	}
+
+	void adopt(QGraphicsItem *item) const {
+		item->setFlag(QGraphicsItem::ItemHasNoContents, _batch);
+	}
+
+	CircleItem* circleOf(const TreeNode *node) const {
+		return _indexToCircle.at(node->_index);
+	}
 
 	void check(TreeNode *node, std::string &path, std::vector<std::string>& result) const;
 
+	void weakest(const TreeNode *node, std::string &path,
+	             std::vector<std::pair<qreal, std::string>>& leaves) const;
+
 	CircleItem* addCircle(const QPointF& center, qreal radius);
 
 	void delCircle(const CircleItem* circle);
@@ -211,14 +321,53 @@ private:
 
 	void delKnot(const KnotItem* knot);
 
+	enum Dirty { Clean = 0, Items = 1, Knots = 2 };
+
+	void invalidate(int dirty);
+
 	void updateKnots();
 
 	void update();
 
+	Cell currentCell() const;
+	void measureSplit();
+	void rebuildKnots();
+
+	void redraw();
+
+	void syncCenter();
+
+	//Снимает отметки пустых ветвей с поддерева
+	void clearEmpty(TreeNode *node, int depth, bool attached);
+
+	void invalidatePath();
+
+	bool isAttached() const {
+		return _treeNode && (attachedCount() == int(_treePath.size()) + 1);
+	}
+
+	//Число узлов текущего пути, уже входящих в дерево
+	int attachedCount() const;
+
+	void updatePending();
+
+	std::string nodePath() const {
+		return _textPath.substr(0, _treePath.size());
+	}
+
+	void refreshHeat();
+
+	void renderHeat();
+
+	QTransform heatView() const;
+
+	void showHeat(const QImage &image, int generation);
+
 	std::vector<std::shared_ptr<TreeNode>> _treePath;
 	std::string _textPath;
 	std::shared_ptr<TreeNode> _treeNode;
 	std::shared_ptr<TreeNode> _treeRoot;
+	TreeStats _stats;
 
 	std::vector<QGraphicsLineItem*> _lines;
 
@@ -231,6 +380,9 @@ private:
 	KnotItem* _knot2 = nullptr;
 
 	QPointF _prev;
+	QPointF _drag;
+	QTimer _frame;
+	int _dirty = Dirty::Clean;
 
 	QPointF _center = {0., 0.};
 	qreal _scale = 1.;
@@ -239,7 +391,36 @@ private:
 	bool _filledArea = false;
 	Mode _mode = Free;
 
+	//Карта исходов строится по снимку дерева с номером правки
+	HeatMap _heat;
+	QGraphicsPixmapItem *_heatItem = nullptr;
+	std::shared_ptr<const Classifier> _classifier;
+	quint64 _revision = 0;
+	quint64 _heatRevision = 0;
+	QTransform _heatView;
+	QTimer _heatDelay;	//Снимок берется, когда правки затихли
+	std::shared_ptr<const QuadTree> _quadTree;
+
+	//Путь предпросмотра под курсором; false - состояние окружностей неизвестно
+	std::vector<std::pair<const TreeNode*, bool>> _hoverPath;
+	bool _hoverValid = false;
+	bool _hover = false;
+	quint64 _quadRevision = 0;
+
+	//Пакетная отрисовка: элементы только хранят состояние
+	LayerItem *_back = nullptr;
+	LayerItem *_front = nullptr;
+	bool _batch = false;
+
+	//Выборка текущей ячейки для площадей частей при перетаскивании
+	std::vector<QPointF> _split;
+	std::vector<QPointF> _splitInside;
+	qreal _splitWeight = 0.;	//Площадь, приходящаяся на точку выборки
+	qreal _splitStep = 0.;
+
 	Monitor *_monitor = nullptr;
+	Recorder *_recorder = nullptr;
+	Journal *_journal = nullptr;
 };
 
 #endif //__INCLUDE_GRAPHICSSCENE_H
@@ -0,0 +1,55 @@
+#ifndef __INCLUDE_HEATMAP_H
+#define __INCLUDE_HEATMAP_H
+
+#include <classifier.hpp>
+#include <QTransform>
+#include <QThread>
+#include <QImage>
+#include <QMutex>
+#include <atomic>
+
+//Растровая карта исходов классификации, уточняемая от грубой к точной
+class HeatMap: public QThread {
+	Q_OBJECT
+public:
+	explicit HeatMap(QObject *parent = nullptr);
+	~HeatMap();
+
+	//Прерывает текущее построение и начинает новое, не дожидаясь
+	//остановки прежнего
+	void render(std::shared_ptr<const Classifier> classifier,
+	            const QRectF &rect, const QTransform &toModel);
+
+	//Прерывает построение и отбрасывает отложенное
+	void cancel();
+
+	int getGeneration() const { return _generation; }
+
+	static QRgb color(const Outcome &outcome);
+
+signals:
+	void imageReady(const QImage &image, int generation);
+
+protected:
+	virtual void run() override;
+
+private:
+	struct Job {
+		std::shared_ptr<const Classifier> _classifier;
+		QRectF _rect;
+		QTransform _toModel;
+		int _generation = 0;
+	};
+
+	void draw(const Job &job);
+
+	//Следующее задание передается потоку под мьютексом
+	QMutex _mutex;
+	Job _job;
+	bool _pending = false;
+	bool _active = false;
+	std::atomic<bool> _cancel{false};
+	int _generation = 0;
+};
+
+#endif //__INCLUDE_HEATMAP_H
@@ -0,0 +1,76 @@
+#ifndef __INCLUDE_JOURNAL_H
+#define __INCLUDE_JOURNAL_H
+
+#include <treenode.hpp>
+#include <QDataStream>
+#include <QObject>
+#include <QString>
+#include <QFile>
+
+//Журнал правок дерева, дописываемый рядом с файлом дерева
+class Journal: public QObject {
+	Q_OBJECT
+public:
+	enum Op: quint8 { Create, Center, Fix, Prune };
+
+	//Размер журнала, после которого его стоит свернуть в полное сохранение
+	static constexpr qint64 LIMIT = 1 << 20;
+
+	explicit Journal(QObject *parent = nullptr);
+	~Journal();
+
+	static QString fileName(const QString &treeFile) {
+		return treeFile + ".journal";
+	}
+
+	bool open(const QString &treeFile);
+	void close();
+	bool isOpen() const { return _file.isOpen(); }
+	const QString& getTreeFile() const { return _treeFile; }
+
+	void create(const std::string &path, const QPointF &center) {
+		write(Create, path, center);
+	}
+	void center(const std::string &path, const QPointF &center) {
+		write(Center, path, center);
+	}
+	void fix(const std::string &path) { write(Fix, path); }
+	void prune(const std::string &path) { write(Prune, path); }
+
+	void requestCompaction();
+
+	//Положение в журнале, соответствующее снимку дерева
+	qint64 mark();
+
+	//Отбрасывает записи до отметки, уже вошедшие в полное сохранение.
+	//Остаток переносится в журнал файла treeFile, по умолчанию текущего
+	bool compact(qint64 mark, const QString &treeFile = QString());
+
+	//Возвращает число примененных записей или -1 при ошибке
+	static qint64 replay(const QString &treeFile, TreeDocument &doc,
+	                     QString *error = nullptr);
+
+signals:
+	void compactionNeeded();
+
+private:
+	template<class... Args>
+	void write(Op op, const std::string &path, const Args&... args) {
+		if (!_file.isOpen()) return;
+		_stream << quint8(op) << QByteArray::fromStdString(path);
+		(_stream << ... << args);
+		_file.flush();
+		if (_file.size() > LIMIT) requestCompaction();
+	}
+
+	static constexpr quint32 MAGIC = 0x43474A4C;
+	static constexpr quint16 VERSION = 1;
+	static constexpr qint64 HEADER = 6;
+
+	QString _treeFile;
+	QFile _file;
+	QDataStream _stream;
+	bool _requested = false;
+};
+
+#endif //__INCLUDE_JOURNAL_H
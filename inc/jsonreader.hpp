@@ -0,0 +1,50 @@
+#ifndef __INCLUDE_JSONREADER_H
+#define __INCLUDE_JSONREADER_H
+
+#include <QByteArray>
+#include <QIODevice>
+
+//Потоковый разбор JSON без построения документа в памяти
+class JsonReader {
+public:
+	enum Token {
+		BeginObject, EndObject,
+		BeginArray, EndArray,
+		String, Number, Bool, Null,
+		End, Invalid
+	};
+
+	explicit JsonReader(QIODevice *device);
+
+	Token next();
+	Token peek();
+
+	bool skip(Token token);
+
+	const QByteArray& text() const { return _text; }
+	double number() const { return _text.toDouble(); }
+	bool boolean() const { return _text == "true"; }
+
+	qint64 pos() const { return _pos; }
+	qint64 size() const { return _size; }
+
+private:
+	Token read();
+	bool fill();
+	int get();
+	int look();
+
+	static constexpr int _chunk = 1 << 16;
+
+	QIODevice *_device;
+	QByteArray _buffer;
+	QByteArray _text;
+	int _offset = 0;
+	qint64 _pos = 0;
+	qint64 _size = 0;
+
+	Token _ahead = Invalid;
+	bool _peeked = false;
+};
+
+#endif //__INCLUDE_JSONREADER_H
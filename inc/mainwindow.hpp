@@ -8,6 +8,13 @@
 #include <QMainWindow>
 #include <monitor.hpp>
 
+class TreeTask;
+class Recorder;
+class MonitorChannel;
+class Journal;
+class Thumbnails;
+class ThumbnailModel;
+
 namespace Ui {
 class MainWindow;
 }
@@ -21,12 +28,16 @@ public:
 	virtual void sendPosition(const QPointF& point, bool fixed) override;
 	virtual void sendTreePath(const QString& path, bool fixed) override;
 	virtual void sendError(const QString& message) override;
+	virtual void sendStats(const TreeStats& stats) override;
+	virtual void sendSplit(qreal inside, qreal outside, bool covered) override;
 
 private slots:
 	void on_buttonPlace_clicked();
 
 	void on_buttonReset_clicked();
 	void on_buttonCheck_clicked();
+	void on_buttonSimplify_clicked();
+	void on_buttonExits_clicked();
 	void on_buttonMode_clicked();
 
 	void on_buttonFalse_clicked();
@@ -38,15 +49,35 @@ private slots:
 	void on_checkChord_clicked();
 	void on_checkPoint_clicked();
 	void on_checkFill_clicked();
+	void on_checkHeat_clicked();
+	void on_checkHover_clicked();
+	void on_checkBatch_clicked();
 
 	void on_buttonPrint_clicked();
 	void on_buttonSave_clicked();
 	void on_buttonOpen_clicked();
+	void on_buttonDiff_clicked();
+	void on_buttonExport_clicked();
+	void on_buttonPoster_clicked();
+	void on_buttonStats_clicked();
+	void on_buttonRecord_clicked();
+	void on_buttonTrace_clicked();
 
 	void on_listView_clicked();
 
+	void compactJournal();
+	void updateNavigation();
+
 private:
-	QStringListModel *listModel;
+	void runTask(TreeTask *task, const QString &label);
+
+	ThumbnailModel *listModel;
+	Thumbnails *thumbnails;
+	Recorder *recorder = nullptr;
+	MonitorChannel *channel;
+	Journal *journal;
+	bool compacting = false;
+	QString currentFile;
 	Ui::MainWindow *ui;
 };
 
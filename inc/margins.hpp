@@ -0,0 +1,34 @@
+#ifndef __INCLUDE_MARGINS_H
+#define __INCLUDE_MARGINS_H
+
+#include <treenode.hpp>
+#include <geometry.hpp>
+
+//Запас устойчивости: насколько можно сдвинуть окружности без отказа.
+//Для листа это зазор между ячейкой и границей последней окружности,
+//для узла - наименьший зазор среди листьев поддерева
+class Margins {
+public:
+	Margins(const Disk &base, const std::vector<qreal> &radius):
+	    _base(base), _radius(radius) {}
+
+	//Пересчитываются только узлы со сброшенным запасом
+	qreal measure(TreeNode *root) const;
+
+private:
+	struct Task {
+		TreeNode *_node;
+		Cell _cell;
+	};
+
+	void collect(TreeNode *node, Cell &cell, int depth, std::vector<Task> &tasks) const;
+	qreal measure(TreeNode *node, Cell &cell) const;
+	static qreal combine(TreeNode *node);
+
+	static constexpr int SPLIT = 4;
+
+	Disk _base;
+	std::vector<qreal> _radius;
+};
+
+#endif //__INCLUDE_MARGINS_H
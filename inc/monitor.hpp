@@ -2,6 +2,7 @@
 #define __INCLUDE_MONITOR_H
 
 #include <QPointF>
+#include "treestats.hpp"
 
 class Monitor {
 public:
@@ -11,6 +12,11 @@ public:
 
 	virtual void sendError(const QString& message) = 0;
 
+	virtual void sendStats(const TreeStats& stats) = 0;
+
+	//Площади частей ячейки внутри и вне перетаскиваемой окружности
+	virtual void sendSplit(qreal inside, qreal outside, bool covered) = 0;
+
 	//...
 
 	virtual ~Monitor() {}
@@ -0,0 +1,51 @@
+#ifndef __INCLUDE_MONITORCHANNEL_H
+#define __INCLUDE_MONITORCHANNEL_H
+
+#include <monitor.hpp>
+#include <QObject>
+#include <QStringList>
+#include <QMutex>
+
+//Очередь уведомлений: повторы одного вида схлопываются,
+//доставка выполняется в потоке, которому принадлежит канал
+class MonitorChannel: public QObject, public Monitor {
+	Q_OBJECT
+public:
+	explicit MonitorChannel(Monitor *target, QObject *parent = nullptr);
+	~MonitorChannel();
+
+	virtual void sendPosition(const QPointF& point, bool fixed) override;
+	virtual void sendTreePath(const QString& path, bool fixed) override;
+	virtual void sendError(const QString& message) override;
+	virtual void sendStats(const TreeStats& stats) override;
+	virtual void sendSplit(qreal inside, qreal outside, bool covered) override;
+
+public slots:
+	//Доставляет накопленные уведомления
+	void deliver();
+
+private:
+	enum Kind { Position = 1, FixedPosition = 2, TreePath = 4, Stats = 8, Split = 16 };
+
+	void post(int kind);
+
+	struct Pending {
+		int _kinds = 0;
+		QPointF _position;
+		QPointF _fixedPosition;
+		QString _path;
+		bool _fixedPath = false;
+		QStringList _errors;
+		TreeStats _stats;
+		qreal _inside = 0.;
+		qreal _outside = 0.;
+		bool _covered = false;
+	};
+
+	Monitor *_target;
+	QMutex _mutex;
+	Pending _pending;
+	bool _posted = false;
+};
+
+#endif //__INCLUDE_MONITORCHANNEL_H
@@ -0,0 +1,44 @@
+#ifndef __INCLUDE_POSTER_H
+#define __INCLUDE_POSTER_H
+
+#include <treefile.hpp>
+#include <QGraphicsScene>
+#include <QBrush>
+#include <QImage>
+#include <QLineF>
+#include <QPen>
+
+//Векторный снимок сцены для вывода в произвольном разрешении.
+//Изображение строится плитками и пишется в несжатый TIFF по мере
+//готовности, так что память ограничена размером пачки плиток
+class Poster {
+public:
+	static constexpr int TILE = 256;
+
+	//Снимок видимых окружностей и линий; вызывается в потоке сцены
+	Poster(QGraphicsScene *scene, int width);
+
+	int getWidth() const { return _width; }
+	int getHeight() const { return _height; }
+
+	QImage renderTile(int column, int row) const;
+
+	bool write(QIODevice *device, const TreeFile::Progress &progress = nullptr,
+	           QString *error = nullptr) const;
+
+private:
+	struct Shape {
+		bool _line;
+		QRectF _rect;
+		QLineF _segment;
+		QPen _pen;
+		QBrush _brush;
+	};
+
+	std::vector<Shape> _shapes;	//В порядке отрисовки
+	QRectF _rect;
+	int _width;
+	int _height;
+};
+
+#endif //__INCLUDE_POSTER_H
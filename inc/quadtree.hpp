@@ -0,0 +1,46 @@
+#ifndef __INCLUDE_QUADTREE_H
+#define __INCLUDE_QUADTREE_H
+
+#include <classifier.hpp>
+#include <QByteArray>
+#include <QString>
+
+//Адаптивное разбиение базового круга на квадраты с общим исходом
+class QuadTree {
+public:
+	static constexpr int DEPTH = 10;
+
+	//Верхние уровни строятся сразу, поддеревья ниже делятся между потоками
+	static std::shared_ptr<QuadTree> build(const Classifier &classifier, int depth = DEPTH);
+
+	//Возвращает false для смешанной ячейки: точку нужно провести по дереву
+	bool find(const QPointF &point, Outcome &outcome) const;
+
+	qint64 size() const { return _nodes.size(); }
+
+	//Отпечаток дерева, по которому построено разбиение
+	static QByteArray fingerprint(const TreeDocument &doc);
+	const QByteArray& getFingerprint() const { return _fingerprint; }
+	void setFingerprint(const QByteArray &fingerprint) { _fingerprint = fingerprint; }
+
+	bool save(const QString &fileName) const;
+	static std::shared_ptr<QuadTree> load(const QString &fileName, const QByteArray &fingerprint);
+
+private:
+	struct Node {
+		qint32 _child = -1;	//Первый из четырех потомков
+		qint32 _leaf = -1;	//Исход ячейки, -1 для смешанной
+	};
+
+	struct Builder;
+
+	static constexpr quint32 MAGIC = 0x43475154;
+	static constexpr quint16 VERSION = 1;
+
+	QRectF _bounds;
+	std::vector<Node> _nodes;
+	std::vector<Outcome> _leaves;
+	QByteArray _fingerprint;
+};
+
+#endif //__INCLUDE_QUADTREE_H
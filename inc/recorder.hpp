@@ -0,0 +1,81 @@
+#ifndef __INCLUDE_RECORDER_H
+#define __INCLUDE_RECORDER_H
+
+#include <treenode.hpp>
+#include <QDataStream>
+#include <QString>
+#include <QFile>
+#include <vector>
+
+class GraphicsScene;
+
+//Журнал операций сцены для воспроизведения и замеров
+class Recorder {
+public:
+	enum Op: quint8 {
+		Load, Start, Mode, Fill, Knots,
+		GoToNext, GoToBack, GoToInv, GoToPath,
+		PlaceToChord, PlaceToLocal, PlaceToPoint,
+		SavePath, Reset, Simplify, Test,
+		Grab, Drag, Release, Knot, Drop, Zoom,
+		Exits,
+		Count
+	};
+
+	struct Timing {
+		qint64 _count = 0;
+		qint64 _total = 0;	//нс
+		qint64 _max = 0;
+	};
+
+	//Пишет операцию, если она не вызвана из другой записываемой операции
+	class Entry {
+	public:
+		template<class... Args>
+		Entry(Recorder *recorder, Op op, const Args&... args): _recorder(recorder) {
+			if (!_recorder) return;
+			if (!_recorder->_depth ++) {
+				_recorder->write(op, args...);
+			}
+		}
+		~Entry() {
+			if (_recorder) -- _recorder->_depth;
+		}
+
+	private:
+		Recorder *_recorder;
+	};
+
+	~Recorder();
+
+	//Вместе с журналом сохраняется начальное состояние сцены
+	bool open(const QString &fileName, const GraphicsScene *scene);
+	void close();
+
+	template<class... Args>
+	void record(Op op, const Args&... args) {
+		Entry entry(this, op, args...);
+	}
+
+	static const char* name(Op op);
+
+	static bool replay(const QString &fileName, GraphicsScene *scene,
+	                   std::vector<Timing> &timing, QString *error = nullptr);
+
+private:
+	template<class... Args>
+	void write(Op op, const Args&... args) {
+		if (!_file.isOpen()) return;
+		_stream << quint8(op);
+		(_stream << ... << args);
+	}
+
+	static constexpr quint32 MAGIC = 0x43475243;
+	static constexpr quint16 VERSION = 2;
+
+	QFile _file;
+	QDataStream _stream;
+	int _depth = 0;
+};
+
+#endif //__INCLUDE_RECORDER_H
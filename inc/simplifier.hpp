@@ -0,0 +1,25 @@
+#ifndef __INCLUDE_SIMPLIFIER_H
+#define __INCLUDE_SIMPLIFIER_H
+
+#include <treenode.hpp>
+#include <geometry.hpp>
+
+//Поиск пустых ветвей и удаление лишних поддеревьев
+class Simplifier {
+public:
+	Simplifier(const Disk &base, const std::vector<qreal> &radius):
+	    _base(base), _radius(radius) {}
+
+	//Возвращает число удаленных узлов
+	qint64 simplify(TreeNode *root) const;
+
+private:
+	bool simplify(TreeNode *node, Cell &cell, qint64 &removed) const;
+
+	static qint64 size(const TreeNode *node);
+
+	Disk _base;
+	std::vector<qreal> _radius;
+};
+
+#endif //__INCLUDE_SIMPLIFIER_H
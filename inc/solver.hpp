@@ -0,0 +1,26 @@
+#ifndef __INCLUDE_SOLVER_H
+#define __INCLUDE_SOLVER_H
+
+#include <treenode.hpp>
+#include <geometry.hpp>
+#include <QDeadlineTimer>
+
+//Жадное построение дерева для заданного набора радиусов
+class Solver {
+public:
+	Solver(const Disk &base, const std::vector<qreal> &radius):
+	    _base(base), _radius(radius) {}
+
+	//Возвращает nullptr, если время истекло
+	std::shared_ptr<TreeNode> solve(const QDeadlineTimer &deadline) const;
+
+private:
+	bool build(TreeNode *node, Cell &cell, const QDeadlineTimer &deadline) const;
+
+	static constexpr int CANDIDATES = 12;
+
+	Disk _base;
+	std::vector<qreal> _radius;
+};
+
+#endif //__INCLUDE_SOLVER_H
@@ -0,0 +1,92 @@
+#ifndef __INCLUDE_THUMBNAILS_H
+#define __INCLUDE_THUMBNAILS_H
+
+#include <classifier.hpp>
+#include <QStringListModel>
+#include <QThreadPool>
+#include <QTimer>
+#include <QImage>
+#include <unordered_map>
+#include <functional>
+#include <string>
+#include <list>
+#include <set>
+
+//Кэш уменьшенных изображений состояний дерева по пути ответов.
+//Изображения строятся в фоне по снимку дерева, при нехватке
+//бюджета вытесняются давно не запрошенные
+class Thumbnails: public QObject {
+	Q_OBJECT
+public:
+	static constexpr int SIZE = 64;
+
+	//Источник снимка опрашивается, только когда номер правки перестал меняться
+	using Source = std::function<std::shared_ptr<const Classifier>()>;
+	using Revision = std::function<quint64()>;
+
+	Thumbnails(const Source &source, const Revision &revision,
+	           qint64 budget, QObject *parent = nullptr);
+	~Thumbnails();
+
+	//Пустое изображение, если его еще нет; построение тогда ставится в очередь
+	QImage find(const std::string &path);
+
+	void setBudget(qint64 budget);
+	qint64 getBytes() const { return _bytes; }
+
+	static QImage render(const Classifier &snapshot, const std::string &path);
+
+	//Подсказка с изображением в двойном размере
+	static QString toolTip(const QImage &image);
+
+signals:
+	void ready(const QString &path);
+	//Правки затихли, изображения стоит запросить заново
+	void changed();
+
+private slots:
+	void store(const QString &path, const QImage &image, qulonglong generation);
+
+private:
+	struct Entry {
+		QImage _image;
+		std::list<std::string>::iterator _order;
+	};
+
+	void evict();
+	void take();
+
+	Source _source;
+	Revision _revision;
+	quint64 _seen = 0;		//Последний замеченный номер правки
+	quint64 _taken = 0;		//Номер правки текущего снимка
+	QTimer _settle;
+	std::shared_ptr<const Classifier> _snapshot;
+	qulonglong _generation = 0;
+	std::list<std::string> _order;	//Начало - последние запрошенные
+	std::unordered_map<std::string, Entry> _cache;
+	std::set<std::string> _pending;
+	qint64 _bytes = 0;
+	qint64 _budget;
+	QThreadPool _pool;
+};
+
+//Список путей с миниатюрами в качестве значков и подсказок
+class ThumbnailModel: public QStringListModel {
+	Q_OBJECT
+public:
+	ThumbnailModel(Thumbnails *thumbnails, QObject *parent = nullptr);
+
+	virtual QVariant data(const QModelIndex &index, int role) const override;
+
+	//Путь - первое слово из 0, 1 и x; остальное - пометки
+	static std::string pathOf(const QString &text);
+
+private:
+	void refresh(const QString &path);
+	void refreshAll();
+
+	Thumbnails *_thumbnails;
+};
+
+#endif //__INCLUDE_THUMBNAILS_H
@@ -0,0 +1,57 @@
+#ifndef __INCLUDE_TRACE_H
+#define __INCLUDE_TRACE_H
+
+#include <QString>
+#include <atomic>
+
+//Интервалы выполнения для просмотра в chrome://tracing или Perfetto.
+//Каждый поток пишет в свой кольцевой буфер без блокировок; пока запись
+//выключена, интервал стоит одной проверки флага
+class Trace {
+public:
+	static void enable(bool enabled) {
+		_enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	static bool isEnabled() {
+		return _enabled.load(std::memory_order_relaxed);
+	}
+
+	//Пишет накопленные интервалы в формате Trace Event JSON. Потоки
+	//могут продолжать запись: интервалы, закрытые во время выгрузки,
+	//попадают в нее или нет, но не портят ее
+	static bool dump(const QString &fileName);
+
+	//Очищает буферы всех потоков, не останавливая их
+	static void clear();
+
+	class Span {
+	public:
+		//Имя должно жить до выгрузки: обычно это строковый литерал
+		explicit Span(const char *name): _name(isEnabled()? name: nullptr) {
+			if (_name) _begin = now();
+		}
+		~Span() {
+			if (_name) record(_name, _begin, now());
+		}
+
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+
+	private:
+		const char *_name;
+		qint64 _begin = 0;
+	};
+
+private:
+	static qint64 now();
+	static void record(const char *name, qint64 begin, qint64 end);
+
+	static std::atomic<bool> _enabled;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(name) Trace::Span TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#endif //__INCLUDE_TRACE_H
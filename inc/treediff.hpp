@@ -0,0 +1,36 @@
+#ifndef __INCLUDE_TREEDIFF_H
+#define __INCLUDE_TREEDIFF_H
+
+#include <treefile.hpp>
+#include <QIODevice>
+#include <QPointF>
+#include <QString>
+#include <functional>
+#include <string>
+
+//Сравнение двух сохраненных деревьев за один проход по файлам
+class TreeDiff {
+public:
+	enum Kind { Added, Removed, Moved };
+
+	struct Change {
+		Kind _kind;
+		std::string _path;
+		QPointF _from;
+		QPointF _to;
+		qint64 _count = 1;	//Число узлов в добавленном или удаленном поддереве
+	};
+
+	using Report = std::function<void(const Change &change)>;
+
+	static bool compare(QIODevice *base, QIODevice *other, qreal tolerance,
+	                    const Report &report,
+	                    const TreeFile::Progress &progress = nullptr,
+	                    QString *error = nullptr);
+
+	static char symbol(Kind kind) {
+		return kind == Added? '+': kind == Removed? '-': '~';
+	}
+};
+
+#endif //__INCLUDE_TREEDIFF_H
@@ -0,0 +1,22 @@
+#ifndef __INCLUDE_TREEFILE_H
+#define __INCLUDE_TREEFILE_H
+
+#include <treenode.hpp>
+#include <QIODevice>
+#include <QString>
+#include <functional>
+
+class TreeFile {
+public:
+	//Возвращает false, если операцию нужно прервать
+	using Progress = std::function<bool(qint64 done, qint64 total)>;
+
+	static bool read(QIODevice *device, TreeDocument &doc,
+	                 const Progress &progress = nullptr,
+	                 QString *error = nullptr);
+
+	static bool write(QIODevice *device, const TreeDocument &doc,
+	                  const Progress &progress = nullptr);
+};
+
+#endif //__INCLUDE_TREEFILE_H
@@ -0,0 +1,67 @@
+#ifndef __INCLUDE_TREEMAP_H
+#define __INCLUDE_TREEMAP_H
+
+#include <graphicsscene.hpp>
+#include <QWidget>
+#include <string>
+#include <map>
+
+//Обзорная схема дерева решений
+class TreeMap: public QWidget {
+	Q_OBJECT
+public:
+	explicit TreeMap(QWidget *parent = nullptr);
+	~TreeMap();
+
+	void setScene(const GraphicsScene *scene) {
+		_scene = scene;
+		update();
+	}
+
+	//Отмеченные пути: '+', '-' или '~'
+	void setMarks(std::map<std::string, char> marks) {
+		_marks = std::move(marks);
+		update();
+	}
+
+signals:
+	void pathClicked(const QString &path);
+
+protected:
+	virtual void paintEvent(QPaintEvent *event) override;
+	virtual void mousePressEvent(QMouseEvent *event) override;
+	virtual void mouseMoveEvent(QMouseEvent *event) override;
+	virtual void mouseReleaseEvent(QMouseEvent *event) override;
+	virtual void wheelEvent(QWheelEvent *event) override;
+
+private:
+	void paintNode(QPainter &painter, const TreeNode *node, std::string &path,
+	               qreal a, qreal b, bool current);
+	void paintOpen(QPainter &painter, std::string &path,
+	               qreal a, qreal b, bool current);
+	void paintMark(QPainter &painter, const std::string &path, const QPointF &p);
+	bool hasMarks(const std::string &path) const;
+
+	qreal toWidget(qreal u) const;
+	qreal fromWidget(qreal x) const;
+	qreal levelY(int depth) const;
+	void clamp();
+
+	static constexpr qreal _margin = 12.;
+	static constexpr qreal _detail = 4.;	//Минимальная ширина раскрываемого поддерева
+
+	const GraphicsScene *_scene = nullptr;
+	std::map<std::string, char> _marks;
+	std::string _path;
+	int _levels = 0;
+	int _depth = 0;
+
+	qreal _left = 0.;
+	qreal _zoom = 1.;
+
+	QPoint _press;
+	QPoint _prev;
+	bool _moved = false;
+};
+
+#endif //__INCLUDE_TREEMAP_H
@@ -0,0 +1,56 @@
+#ifndef __INCLUDE_TREENODE_H
+#define __INCLUDE_TREENODE_H
+
+#include <QPointF>
+#include <memory>
+#include <vector>
+#include <array>
+#include <limits>
+
+struct TreeNode {
+	enum Status { Unknown, Solved, Open, Failed };
+
+	std::array<std::shared_ptr<TreeNode>, 2> _branch;
+	std::array<bool, 2> _empty = {false, false};	//Ячейка ветви пуста
+	QPointF _center;
+	int _index = 1;	//Номер окружности узла
+	bool _fixed = false;
+	bool _exit = false;	//Ранний выход: узел сразу ставит последнюю окружность
+
+	//Кэш результата проверки поддерева
+	Status _status = Unknown;
+	qreal _uncovered = 0.;
+	qreal _margin = std::numeric_limits<qreal>::quiet_NaN();	//Запас устойчивости
+
+	//Сбрасывает кэш одного узла
+	void reset()
+	{
+		_status = Unknown;
+		_margin = std::numeric_limits<qreal>::quiet_NaN();
+	}
+
+	void invalidate()
+	{
+		reset();
+		for (auto &next : _branch) {
+			if (next) next->invalidate();
+		}
+	}
+
+	std::shared_ptr<TreeNode> clone() const
+	{
+		auto node = std::make_shared<TreeNode>(*this);
+		for (auto &next : node->_branch) {
+			if (next) next = next->clone();
+		}
+		return node;
+	}
+};
+
+//Дерево вместе с набором радиусов, не привязанное к сцене
+struct TreeDocument {
+	std::vector<qreal> _radius;
+	std::shared_ptr<TreeNode> _root;
+};
+
+#endif //__INCLUDE_TREENODE_H
@@ -0,0 +1,47 @@
+#ifndef __INCLUDE_TREESTATS_H
+#define __INCLUDE_TREESTATS_H
+
+#include <treenode.hpp>
+#include <QString>
+
+//Счетчики дерева, поддерживаемые при каждой правке
+struct TreeStats {
+	qint64 _nodes = 0;
+	qint64 _fixed = 0;
+	qint64 _open = 0;		//Отсутствующие непустые ветви
+	qint64 _pending = 0;	//Несохраненные узлы текущего пути
+	std::vector<qint64> _depth;	//Число узлов на каждой глубине
+
+	//Вклад одного узла; sign = -1 вычитает его
+	void add(const TreeNode *node, int depth, int levels, int sign = 1)
+	{
+		if (int(_depth.size()) <= depth) _depth.resize(depth + 1);
+		_depth[depth] += sign;
+		_nodes += sign;
+		_fixed += sign * node->_fixed;
+		if (node->_index + 1 >= levels) return;
+		for (int i = 0; i < 2; ++ i) {
+			_open += sign * (!node->_branch[i] && !node->_empty[i]);
+		}
+	}
+
+	void addTree(const TreeNode *node, int depth, int levels, int sign = 1)
+	{
+		add(node, depth, levels, sign);
+		for (const auto &next : node->_branch) {
+			if (next) addTree(next.get(), depth + 1, levels, sign);
+		}
+	}
+
+	qint64 bytes() const {
+		//Узел создается make_shared вместе с блоком счетчиков ссылок
+		return _nodes * qint64(sizeof(TreeNode) + 2 * sizeof(void*));
+	}
+
+	QString toText() const;
+
+	static QString csvHeader();
+	QString toCsv() const;
+};
+
+#endif //__INCLUDE_TREESTATS_H
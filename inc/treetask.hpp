@@ -0,0 +1,84 @@
+#ifndef __INCLUDE_TREETASK_H
+#define __INCLUDE_TREETASK_H
+
+#include <treenode.hpp>
+#include <treediff.hpp>
+#include <quadtree.hpp>
+#include <poster.hpp>
+#include <treefile.hpp>
+#include <QThread>
+#include <QString>
+
+//Чтение и запись дерева в фоновом потоке
+class TreeTask: public QThread {
+	Q_OBJECT
+public:
+	enum Kind { Load, Save, Diff, Export, Image };
+
+	TreeTask(Kind kind, const QString &fileName, QObject *parent = nullptr);
+
+	~TreeTask();
+
+	void setDocument(TreeDocument doc) { _doc = std::move(doc); }
+	TreeDocument takeDocument() { return std::move(_doc); }
+
+	std::shared_ptr<QuadTree> takeQuadTree() { return std::move(_quadTree); }
+
+	//Явное сохранение строит разбиение и пишет его рядом с деревом
+	void setIndexing(bool indexing) { _indexing = indexing; }
+
+	//Положение в журнале на момент снимка документа
+	void setJournalMark(qint64 mark) { _journalMark = mark; }
+	qint64 getJournalMark() const { return _journalMark; }
+
+	//Номер правки сцены на момент снимка документа
+	void setRevision(quint64 revision) { _revision = revision; }
+	quint64 getRevision() const { return _revision; }
+
+	void setPoster(std::shared_ptr<const Poster> poster) { _poster = std::move(poster); }
+
+	void setOther(const QString &fileName) { _other = fileName; }
+	const std::vector<TreeDiff::Change>& getChanges() const { return _changes; }
+
+	const QString& getFileName() const { return _fileName; }
+	const QString& getError() const { return _error; }
+	bool isSucceeded() const { return _succeeded; }
+	bool isCanceled() const { return _canceled; }
+	qint64 getRecovered() const { return _recovered; }
+	Kind getKind() const { return _kind; }
+
+	//Загрузка дерева с применением журнала правок, возвращает число
+	//примененных записей или -1 при ошибке
+	static qint64 read(const QString &fileName, TreeDocument &doc,
+	                   const TreeFile::Progress &progress = nullptr,
+	                   QString *error = nullptr);
+
+signals:
+	void progressChanged(int percent);
+
+protected:
+	virtual void run() override;
+
+private:
+	bool progress(qint64 done, qint64 total);
+
+	void index();
+
+	std::vector<TreeDiff::Change> _changes;
+	TreeDocument _doc;
+	std::shared_ptr<QuadTree> _quadTree;
+	std::shared_ptr<const Poster> _poster;
+	QString _fileName;
+	QString _other;
+	QString _error;
+	bool _succeeded = false;
+	bool _canceled = false;
+	bool _indexing = false;
+	int _percent = -1;
+	qint64 _recovered = 0;
+	qint64 _journalMark = 0;
+	quint64 _revision = 0;
+	Kind _kind;
+};
+
+#endif //__INCLUDE_TREETASK_H
@@ -0,0 +1,23 @@
+#ifndef __INCLUDE_VERIFIER_H
+#define __INCLUDE_VERIFIER_H
+
+#include <treenode.hpp>
+#include <geometry.hpp>
+
+//Проверка покрытия с сохранением результатов в узлах дерева
+class Verifier {
+public:
+	Verifier(const Disk &base, const std::vector<qreal> &radius):
+	    _base(base), _radius(radius) {}
+
+	//Пересчитываются только узлы со сброшенным результатом
+	TreeNode::Status verify(TreeNode *root) const;
+
+private:
+	void verify(TreeNode *node, Cell &cell) const;
+
+	Disk _base;
+	std::vector<qreal> _radius;
+};
+
+#endif //__INCLUDE_VERIFIER_H
@@ -0,0 +1,56 @@
+#include <classifier.hpp>
+#include <quadtree.hpp>
+
+//Ответ: 0 или 1, отрицательный при неоднозначности
+template<class Answer>
+bool Classifier::walk(const Answer &answer, Outcome &outcome) const
+{
+	outcome._kind = Outcome::Open;
+	const int last = int(_radius.size()) - 1;
+	const TreeNode *node = _root.get();
+	while (node) {
+		int ans = answer(Disk{node->_center, _radius[node->_index]});
+		if (ans < 0) return false;
+		if (node->_index >= last) {
+			outcome._kind = ans? Outcome::Covered: Outcome::Failed;
+			return true;
+		}
+		outcome._path = (outcome._path << 1) | ans;
+		++ outcome._depth;
+		if (node->_empty[ans]) {
+			//Точка попала в ячейку, признанную пустой
+			outcome._kind = Outcome::Failed;
+			return true;
+		}
+		node = node->_branch[ans].get();
+	}
+	return true;
+}
+
+Outcome Classifier::classify(const QPointF &point) const
+{
+	Outcome outcome;
+	if (_quadTree && _quadTree->find(point, outcome)) return outcome;
+	if (!_base.contains(point)) return outcome;
+
+	walk([&](const Disk &disk) {
+		return int(disk.contains(point));
+	}, outcome);
+	return outcome;
+}
+
+bool Classifier::classify(const QRectF &rect, Outcome &outcome) const
+{
+	outcome = Outcome();
+	auto relation = _base.relate(rect);
+	if (relation == Disk::Outside) return true;
+	if (relation == Disk::Crossing) return false;
+
+	return walk([&](const Disk &disk) {
+		switch (disk.relate(rect)) {
+		case Disk::Inside: return 1;
+		case Disk::Outside: return 0;
+		default: return -1;
+		}
+	}, outcome);
+}
@@ -0,0 +1,144 @@
+#include <codegen.hpp>
+#include <QLocale>
+#include <QRegExp>
+
+namespace {
+
+//Коды исходов совпадают с константами в созданном заголовке
+constexpr qint32 OUTSIDE = -1, FAILED = -2, OPEN = -3, LEAF = -4;
+
+struct Entry {
+	QPointF center;
+	qreal rq;
+	qint32 next[2];
+};
+
+struct Flattener {
+	explicit Flattener(const TreeDocument &doc): doc(doc) {}
+
+	//Узлы нумеруются в прямом порядке, поддеревья лежат подряд
+	qint32 add(const TreeNode *node)
+	{
+		qint32 index = entries.size();
+		qreal r = doc._radius.at(node->_index);
+		entries.push_back({node->_center, r * r, {FAILED, FAILED}});
+		if (node->_index + 1 >= int(doc._radius.size())) {
+			//Лист: внутри последней окружности точка накрыта
+			entries[index].next[1] = LEAF - leaves ++;
+			return index;
+		}
+		for (int i = 0; i < 2; ++ i) {
+			auto *next = node->_branch[i].get();
+			qint32 value = next? add(next):
+			               node->_empty[i]? FAILED: OPEN;
+			entries[index].next[i] = value;
+		}
+		return index;
+	}
+
+	const TreeDocument &doc;
+	std::vector<Entry> entries;
+	qint32 leaves = 0;
+};
+
+QByteArray number(qreal value)
+{
+	QByteArray text = QByteArray::number(value, 'g', QLocale::FloatingPointShortest);
+	if (!text.contains('.') && !text.contains('e') && !text.contains('n') && !text.contains('i')) {
+		text += ".0";
+	}
+	return text;
+}
+
+}
+
+bool CodeGen::write(QIODevice *device, const TreeDocument &doc, const QString &space,
+                    const TreeFile::Progress &progress, QString *error)
+{
+	auto fail = [error](const QString &message) {
+		if (error) *error = message;
+		return false;
+	};
+	if (doc._radius.size() < 2) return fail("Not enough circles!");
+	if (!QRegExp("[A-Za-z_][A-Za-z0-9_]*").exactMatch(space)) {
+		return fail("Invalid namespace!");
+	}
+
+	Flattener flat(doc);
+	if (doc._root) flat.add(doc._root.get());
+	const qint64 total = flat.entries.size();
+
+	QByteArray buffer;
+	auto flush = [&]() {
+		if (device->write(buffer) != buffer.size()) return false;
+		buffer.clear();
+		return true;
+	};
+	qreal base = doc._radius.front();
+	buffer +=
+	    "// Generated by CircleGen, do not edit.\n"
+	    "#pragma once\n"
+	    "\n"
+	    "#include <cstddef>\n"
+	    "#include <cstdint>\n"
+	    "\n"
+	    "namespace " + space.toUtf8() + " {\n"
+	    "\n"
+	    "// classify() returns the index of the final circle that covers the point\n"
+	    "// (numbered in depth-first order) or one of the negative codes below.\n"
+	    "constexpr int OUTSIDE = -1;\t// outside the base circle\n"
+	    "constexpr int FAILED = -2;\t// the answers lead outside every final circle\n"
+	    "constexpr int OPEN = -3;\t// the answers lead to a missing branch\n"
+	    "\n"
+	    "struct Node {\n"
+	    "\tdouble x, y, rq;\t// center and squared radius\n"
+	    "\tstd::int32_t next[2];\t// node index, or a code below -3 for a covered leaf\n"
+	    "};\n"
+	    "\n"
+	    "constexpr double BASE_RQ = " + number(base * base) + ";\n"
+	    "constexpr std::size_t NODES = " + QByteArray::number(total) + ";\n"
+	    "constexpr std::size_t LEAVES = " + QByteArray::number(flat.leaves) + ";\n"
+	    "\n"
+	    "constexpr Node TREE[" + QByteArray::number(std::max<qint64>(total, 1)) + "] = {\n";
+	for (qint64 i = 0; i < total; ++ i) {
+		const auto &e = flat.entries[i];
+		buffer += "\t{" + number(e.center.x()) + ", " + number(e.center.y()) + ", " +
+		          number(e.rq) + ", {" + QByteArray::number(e.next[0]) + ", " +
+		          QByteArray::number(e.next[1]) + "}},\n";
+		if ((buffer.size() >= (1 << 16)) && !flush()) {
+			return fail(device->errorString());
+		}
+		if (((i + 1) % 4096 == 0) && progress && !progress(i + 1, total)) {
+			return fail("Operation canceled!");
+		}
+	}
+	if (!total) buffer += "\t{0.0, 0.0, 0.0, {OPEN, OPEN}},\n";
+	buffer +=
+	    "};\n"
+	    "\n"
+	    "constexpr int classify(double x, double y) noexcept\n"
+	    "{\n"
+	    "\tif (x * x + y * y > BASE_RQ) return OUTSIDE;\n"
+	    "\tstd::int32_t i = " + QByteArray(total? "0": "OPEN") + ";\n"
+	    "\twhile (i >= 0) {\n"
+	    "\t\tconst Node &n = TREE[i];\n"
+	    "\t\tdouble dx = x - n.x, dy = y - n.y;\n"
+	    "\t\ti = n.next[dx * dx + dy * dy <= n.rq];\n"
+	    "\t}\n"
+	    "\treturn (i <= -4)? -4 - i: i;\n"
+	    "}\n"
+	    "\n"
+	    "// out[k] = classify(x[k], y[k]) for k < count; any indexable types work.\n"
+	    "template<class X, class Y, class Out>\n"
+	    "void classify(std::size_t count, const X &x, const Y &y, Out &&out)\n"
+	    "{\n"
+	    "\tfor (std::size_t k = 0; k < count; ++ k) {\n"
+	    "\t\tout[k] = classify(double(x[k]), double(y[k]));\n"
+	    "\t}\n"
+	    "}\n"
+	    "\n"
+	    "} // namespace " + space.toUtf8() + "\n";
+	if (!flush()) return fail(device->errorString());
+	if (progress) progress(total, total);
+	return true;
+}
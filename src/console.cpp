@@ -0,0 +1,420 @@
+#include <console.hpp>
+#include <treediff.hpp>
+#include <graphicsscene.hpp>
+#include <recorder.hpp>
+#include <solver.hpp>
+#include <verifier.hpp>
+#include <codegen.hpp>
+#include <earlyexit.hpp>
+#include <treestats.hpp>
+#include <trace.hpp>
+#include <QSaveFile>
+#include <QApplication>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QMutex>
+#include <QRegExp>
+#include <functional>
+#include <set>
+#include <map>
+#include <QFile>
+#include <QDirIterator>
+#include <QThreadPool>
+#include <cstring>
+
+bool Console::accepts(int argc, char *argv[])
+{
+	return (argc > 1) && !std::strncmp(argv[1], "--", 2);
+}
+
+int Console::exec(int argc, char *argv[])
+{
+	//Сцене нужен QApplication, но не нужен экран
+	if (!std::strcmp(argv[1], "--replay")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+		QApplication app(argc, argv);
+		return replay(app.arguments().mid(2));
+	}
+	QCoreApplication app(argc, argv);
+	QStringList args = app.arguments();
+	args.removeFirst();
+	QString command = args.takeFirst();
+	if (command == "--diff") {
+		return diff(args);
+	}
+	if (command == "--sweep") {
+		return sweep(args);
+	}
+	if (command == "--export-cpp") {
+		return exportCpp(args);
+	}
+	if (command == "--early-exit") {
+		return earlyExit(args);
+	}
+	if (command == "--corpus") {
+		return corpus(args);
+	}
+	return usage();
+}
+
+int Console::usage()
+{
+	QTextStream err(stderr);
+	err << "Usage:\n"
+	    << "  CircleGen --diff <base.json> <other.json> [tolerance]\n"
+	    << "  CircleGen --replay <session.cgr>\n"
+	    << "  CircleGen --sweep <radius.txt> <results.csv> [--timeout seconds]\n"
+	    << "  CircleGen --export-cpp <tree.json> <tree.hpp> [namespace]\n"
+	    << "  CircleGen --early-exit <tree.json> <result.json>\n"
+	    << "  CircleGen --corpus <directory> <summary.csv> [--jobs count]\n";
+	return 2;
+}
+
+int Console::diff(const QStringList &args)
+{
+	QTextStream out(stdout), err(stderr);
+	if (args.size() < 2) return usage();
+	qreal tolerance = 1.e-7;
+	if (args.size() > 2) {
+		bool ok;
+		tolerance = args[2].toDouble(&ok);
+		if (!ok) return usage();
+	}
+	QFile base(args[0]), other(args[1]);
+	for (auto *file : {&base, &other}) {
+		if (!file->open(QIODevice::ReadOnly)) {
+			err << file->fileName() << ": " << file->errorString() << "\n";
+			return 2;
+		}
+	}
+	qint64 changes = 0;
+	QString error;
+	bool ok = TreeDiff::compare(&base, &other, tolerance,
+	[&](const TreeDiff::Change &change) {
+		out << TreeDiff::symbol(change._kind) << ' ' << change._path.c_str();
+		if (change._kind == TreeDiff::Moved) {
+			out << " (" << change._from.x() << ", " << change._from.y() << ") -> ("
+			    << change._to.x() << ", " << change._to.y() << ")";
+		}
+		else {
+			out << " [" << change._count << "]";
+		}
+		out << "\n";
+		++ changes;
+	}, nullptr, &error);
+	if (!ok) {
+		err << error << "\n";
+		return 2;
+	}
+	return changes? 1: 0;
+}
+
+int Console::replay(const QStringList &args)
+{
+	QTextStream out(stdout), err(stderr);
+	if (args.size() < 1) return usage();
+
+	GraphicsScene scene;
+	scene.setSceneRect(0, 0, 512, 512);
+	scene.init();
+	std::vector<Recorder::Timing> timing;
+	QString error;
+	if (!Recorder::replay(args[0], &scene, timing, &error)) {
+		err << error << "\n";
+		return 2;
+	}
+	auto line = [&out](const QString &name, const Recorder::Timing &t) {
+		out << QString("%1%2%3%4%5\n")
+		       .arg(name, -14)
+		       .arg(t._count, 10)
+		       .arg(t._total / 1.e6, 14, 'f', 3)
+		       .arg(t._total / 1.e3 / t._count, 14, 'f', 3)
+		       .arg(t._max / 1.e3, 14, 'f', 3);
+	};
+	out << QString("%1%2%3%4%5\n")
+	       .arg("operation", -14).arg("count", 10)
+	       .arg("total, ms", 14).arg("mean, us", 14).arg("max, us", 14);
+	Recorder::Timing sum;
+	for (int op = 0; op < Recorder::Count; ++ op) {
+		const auto &t = timing[op];
+		if (!t._count) continue;
+		line(Recorder::name(Recorder::Op(op)), t);
+		sum._count += t._count;
+		sum._total += t._total;
+		sum._max = std::max(sum._max, t._max);
+	}
+	if (sum._count) line("total", sum);
+	return 0;
+}
+
+int Console::sweep(const QStringList &args)
+{
+	QTextStream out(stdout), err(stderr);
+	if (args.size() < 2) return usage();
+	qint64 timeout = 60;
+	if (args.size() > 2) {
+		bool ok = (args.size() == 4) && (args[2] == "--timeout");
+		if (ok) timeout = args[3].toLongLong(&ok);
+		if (!ok || (timeout <= 0)) return usage();
+	}
+
+	//Набор радиусов на строку, пустые строки и # пропускаются
+	QFile input(args[0]);
+	if (!input.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		err << input.fileName() << ": " << input.errorString() << "\n";
+		return 2;
+	}
+	std::vector<std::vector<qreal>> family;
+	for (int line = 1; !input.atEnd(); ++ line) {
+		QString text = QString::fromUtf8(input.readLine()).section('#', 0, 0);
+		auto items = text.split(QRegExp("[\\s,;]+"), QString::SkipEmptyParts);
+		if (items.isEmpty()) continue;
+		std::vector<qreal> radius;
+		for (const auto &item : items) {
+			bool ok;
+			radius.push_back(item.toDouble(&ok));
+			if (!ok || (radius.back() <= 0.)) radius.clear();
+			if (radius.empty()) break;
+		}
+		if (radius.size() < 2) {
+			err << input.fileName() << ":" << line << ": invalid radius list\n";
+			continue;
+		}
+		family.push_back(std::move(radius));
+	}
+	auto key = [](const std::vector<qreal> &radius) {
+		QStringList list;
+		for (auto r : radius) list << QString::number(r, 'g', 17);
+		return list.join(' ');
+	};
+
+	//Уже посчитанные строки результатов не повторяем
+	QFile results(args[1]);
+	std::set<QString> done;
+	if (results.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		while (!results.atEnd()) {
+			done.insert(QString::fromUtf8(results.readLine()).section(',', 0, 0));
+		}
+		results.close();
+	}
+	bool header = !results.exists() || !results.size();
+	if (!results.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+		err << results.fileName() << ": " << results.errorString() << "\n";
+		return 2;
+	}
+	QTextStream table(&results);
+	if (header) {
+		table << "radius,status,uncovered,nodes,ms\n";
+		table.flush();
+	}
+	std::vector<std::vector<qreal>> pending;
+	for (auto &radius : family) {
+		if (!done.count(key(radius))) pending.push_back(std::move(radius));
+	}
+	out << "instances: " << family.size() << ", pending: " << pending.size() << "\n";
+	out.flush();
+
+	QMutex mutex;
+	int finished = 0;
+	QtConcurrent::blockingMap(pending, [&](const std::vector<qreal> &radius) {
+		TRACE_SPAN("Console::sweep");
+		QElapsedTimer timer;
+		timer.start();
+		Disk base{{0., 0.}, radius.front()};
+		auto root = Solver(base, radius).solve(QDeadlineTimer(timeout * 1000));
+		QString status = "timeout";
+		qreal uncovered = 0.;
+		qint64 nodes = 0;
+		if (root) {
+			switch (Verifier(base, radius).verify(root.get())) {
+			case TreeNode::Solved: status = "solved"; break;
+			case TreeNode::Failed: status = "failed"; break;
+			default: status = "open"; break;
+			}
+			uncovered = root->_uncovered;
+			std::function<qint64(const TreeNode*)> size = [&size](const TreeNode *node) -> qint64 {
+				if (!node) return 0;
+				return 1 + size(node->_branch[0].get()) + size(node->_branch[1].get());
+			};
+			nodes = size(root.get());
+		}
+		qint64 ms = timer.elapsed();
+
+		//Строка пишется сразу, чтобы прерванный прогон можно было продолжить
+		QMutexLocker lock(&mutex);
+		table << key(radius) << ',' << status << ','
+		      << QString::number(uncovered, 'g', 6) << ','
+		      << nodes << ',' << ms << "\n";
+		table.flush();
+		out << ++ finished << "/" << pending.size() << " " << status << " " << key(radius) << "\n";
+		out.flush();
+	});
+	return 0;
+}
+
+int Console::exportCpp(const QStringList &args)
+{
+	QTextStream err(stderr);
+	if (args.size() < 2) return usage();
+	QFile input(args[0]);
+	if (!input.open(QIODevice::ReadOnly)) {
+		err << input.fileName() << ": " << input.errorString() << "\n";
+		return 2;
+	}
+	TreeDocument doc;
+	QString error;
+	if (!TreeFile::read(&input, doc, nullptr, &error)) {
+		err << input.fileName() << ": " << error << "\n";
+		return 2;
+	}
+	QSaveFile output(args[1]);
+	if (!output.open(QIODevice::WriteOnly)) {
+		err << output.fileName() << ": " << output.errorString() << "\n";
+		return 2;
+	}
+	QString space = (args.size() > 2)? args[2]: "circlegen";
+	if (!CodeGen::write(&output, doc, space, nullptr, &error) || !output.commit()) {
+		err << output.fileName() << ": " << (error.isEmpty()? output.errorString(): error) << "\n";
+		return 2;
+	}
+	return 0;
+}
+
+int Console::earlyExit(const QStringList &args)
+{
+	QTextStream out(stdout), err(stderr);
+	if (args.size() != 2) return usage();
+	QFile input(args[0]);
+	if (!input.open(QIODevice::ReadOnly)) {
+		err << input.fileName() << ": " << input.errorString() << "\n";
+		return 2;
+	}
+	TreeDocument doc;
+	QString error;
+	if (!TreeFile::read(&input, doc, nullptr, &error)) {
+		err << input.fileName() << ": " << error << "\n";
+		return 2;
+	}
+	Disk base{{0., 0.}, doc._radius.front()};
+	EarlyExit early(base, doc._radius);
+	qreal before = early.expectedDepth(doc._root);
+	auto exits = early.analyze(doc._root.get());
+	qint64 removed = early.rewrite(doc._root.get(), exits);
+	qreal after = early.expectedDepth(doc._root);
+	out << "early exits: " << exits.size() << ", removed nodes: " << removed
+	    << ", expected depth: " << before << " -> " << after << "\n";
+
+	QSaveFile output(args[1]);
+	if (!output.open(QIODevice::WriteOnly) ||
+	    !TreeFile::write(&output, doc) || !output.commit()) {
+		err << output.fileName() << ": " << output.errorString() << "\n";
+		return 2;
+	}
+	return 0;
+}
+
+//Текстовое поле CSV: поле с разделителями или кавычками берется
+//в кавычки, а кавычки внутри удваиваются
+static QString csv(QString text)
+{
+	if (!text.contains(QRegExp("[,\"\r\n]"))) return text;
+	return '"' + text.replace('"', "\"\"") + '"';
+}
+
+int Console::corpus(const QStringList &args)
+{
+	QTextStream out(stdout), err(stderr);
+	if (args.size() < 2) return usage();
+	int jobs = QThread::idealThreadCount();
+	if (args.size() > 2) {
+		bool ok = (args.size() == 4) && (args[2] == "--jobs");
+		if (ok) jobs = args[3].toInt(&ok);
+		if (!ok || (jobs <= 0)) return usage();
+	}
+
+	//Сначала собираем только имена: в памяти одновременно не больше jobs деревьев
+	QStringList files;
+	QDirIterator it(args[0], {"*.json"}, QDir::Files, QDirIterator::Subdirectories);
+	while (it.hasNext()) files << it.next();
+	files.sort();
+
+	//Строки дописываются по мере готовности: прерванный прогон оставляет
+	//таблицу с уже проверенными файлами
+	QFile summary(args[1]);
+	if (!summary.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		err << summary.fileName() << ": " << summary.errorString() << "\n";
+		return 2;
+	}
+	QTextStream table(&summary);
+	table << "file,status,circles,nodes,fixed,open,depth,expected,uncovered,ms,error\n";
+	table.flush();
+	out << "files: " << files.size() << "\n";
+	out.flush();
+
+	QDir root(args[0]);
+	QMutex mutex;
+	int finished = 0;
+	std::map<QString, int> counts;
+	//Свой пул: общий остается проверке и оценке выхода внутри задач
+	QThreadPool pool;
+	pool.setMaxThreadCount(jobs);
+	auto check = [&](const QString &fileName) {
+		TRACE_SPAN("Console::corpus");
+		QElapsedTimer timer;
+		timer.start();
+		QString status = "invalid", error;
+		TreeDocument doc;
+		TreeStats stats;
+		qreal expected = 0., uncovered = 0.;
+		QFile input(fileName);
+		if (!input.open(QIODevice::ReadOnly)) {
+			error = input.errorString();
+		}
+		else
+		if (TreeFile::read(&input, doc, nullptr, &error)) {
+			input.close();
+			Disk base{{0., 0.}, doc._radius.front()};
+			if (doc._root) {
+				stats.addTree(doc._root.get(), 0, doc._radius.size());
+			}
+			switch (Verifier(base, doc._radius).verify(doc._root.get())) {
+			case TreeNode::Solved: status = "solved"; break;
+			case TreeNode::Failed: status = "failed"; break;
+			default: status = "open"; break;
+			}
+			if (doc._root) uncovered = doc._root->_uncovered;
+			expected = EarlyExit(base, doc._radius).expectedDepth(doc._root);
+		}
+		qint64 ms = timer.elapsed();
+		qint64 circles = doc._radius.size();
+		doc = TreeDocument();
+
+		//Путь в таблице относителен каталогу
+		QMutexLocker lock(&mutex);
+		table << csv(root.relativeFilePath(fileName)) << ',' << csv(status) << ','
+		      << circles << ',' << stats._nodes << ',' << stats._fixed << ','
+		      << stats._open << ',' << qint64(stats._depth.size()) << ','
+		      << QString::number(expected, 'g', 6) << ','
+		      << QString::number(uncovered, 'g', 6) << ',' << ms << ','
+		      << csv(error) << "\n";
+		table.flush();
+		++ counts[status];
+		if (++ finished % 100 == 0) {
+			out << finished << "/" << files.size() << "\n";
+			out.flush();
+		}
+	};
+	for (const QString &fileName : files) {
+		QtConcurrent::run(&pool, check, fileName);
+	}
+	pool.waitForDone();
+	if ((table.status() != QTextStream::Ok) || !summary.flush()) {
+		err << summary.fileName() << ": " << summary.errorString() << "\n";
+		return 2;
+	}
+	for (const auto &[status, count] : counts) {
+		out << status << ": " << count << "\n";
+	}
+	return counts.count("invalid")? 1: 0;
+}
@@ -0,0 +1,155 @@
+#include <earlyexit.hpp>
+#include <classifier.hpp>
+#include <trace.hpp>
+#include <QtConcurrent>
+
+qint64 EarlyExit::size(const TreeNode *node)
+{
+	if (!node) return 0;
+	return 1 + size(node->_branch[0].get()) +
+	           size(node->_branch[1].get());
+}
+
+bool EarlyExit::fits(const Cell &cell, QPointF &center) const
+{
+	qreal r = _radius.back();
+
+	//Круг по части точек не больше круга по всей ячейке
+	auto coarse = cell.samples(COARSE);
+	if (coarse.empty() || (enclose(std::move(coarse))._radius > r)) {
+		return false;
+	}
+	//Центр подбираем по точкам ячейки и концам дуг ее границы,
+	//а вложенность ячейки в круг проверяем точно
+	auto points = cell.samples(Cell::RESOLUTION);
+	cell.arcs([&points](const Disk &arc, qreal a, qreal b) {
+		for (qreal t : {a, b}) {
+			points.push_back(arc._center + arc._radius * QPointF(std::cos(t), std::sin(t)));
+		}
+		return true;
+	});
+	Disk disk = enclose(std::move(points));
+	if (disk._radius > r) return false;
+	if (!cell.isInside({disk._center, r})) return false;
+	center = disk._center;
+	return true;
+}
+
+std::vector<EarlyExit::Exit> EarlyExit::analyze(const TreeNode *root) const
+{
+	std::vector<Exit> exits;
+	if (!root || (_radius.size() < 2)) return exits;
+
+	//Поддеревья на глубине SPLIT разбираются независимо
+	std::vector<Task> tasks;
+	Cell cell(_base);
+	std::string path;
+	collect(root, cell, path, tasks, exits);
+	QtConcurrent::blockingMap(tasks, [this](Task &task) {
+		TRACE_SPAN("EarlyExit::analyze");
+		analyze(task._node, task._cell, task._path, task._exits);
+	});
+	for (auto &task : tasks) {
+		exits.insert(exits.end(), task._exits.begin(), task._exits.end());
+	}
+	return exits;
+}
+
+void EarlyExit::collect(const TreeNode *node, Cell &cell, std::string &path,
+                        std::vector<Task> &tasks, std::vector<Exit> &exits) const
+{
+	if (int(path.size()) >= SPLIT) {
+		tasks.push_back({node, cell, path, {}});
+		return;
+	}
+	if (node->_exit || (node->_index + 1 >= int(_radius.size()))) return;
+	QPointF center;
+	if (fits(cell, center)) {
+		exits.push_back({path, center});
+		return;
+	}
+	Disk disk{node->_center, _radius.at(node->_index)};
+	for (int i = 0; i < 2; ++ i) {
+		auto *next = node->_branch[i].get();
+		if (!next) continue;
+		cell.push(disk, i);
+		path.push_back('0' + i);
+		collect(next, cell, path, tasks, exits);
+		path.pop_back();
+		cell.pop();
+	}
+}
+
+void EarlyExit::analyze(const TreeNode *node, Cell &cell, std::string &path,
+                        std::vector<Exit> &exits) const
+{
+	//Листья уже ставят последнюю окружность, выигрыша нет
+	if (node->_exit || (node->_index + 1 >= int(_radius.size()))) return;
+	QPointF center;
+	if (fits(cell, center)) {
+		exits.push_back({path, center});
+		return;
+	}
+	Disk disk{node->_center, _radius.at(node->_index)};
+	for (int i = 0; i < 2; ++ i) {
+		auto *next = node->_branch[i].get();
+		if (!next) continue;
+		cell.push(disk, i);
+		path.push_back('0' + i);
+		analyze(next, cell, path, exits);
+		path.pop_back();
+		cell.pop();
+	}
+}
+
+qint64 EarlyExit::rewrite(TreeNode *root, const std::vector<Exit> &exits) const
+{
+	qint64 removed = 0;
+	if (!root) return removed;
+	for (const auto &exit : exits) {
+		TreeNode *node = root;
+		for (char c : exit._path) {
+			node->reset();
+			node = node->_branch[c == '1'].get();
+			if (!node) break;
+		}
+		if (!node) continue;
+		removed += size(node) - 1;
+		node->_branch = {};
+		node->_empty = {false, false};
+		node->_center = exit._center;
+		node->_index = int(_radius.size()) - 1;
+		node->_exit = true;
+		node->_fixed = true;
+		node->reset();
+	}
+	return removed;
+}
+
+qreal EarlyExit::expectedDepth(std::shared_ptr<const TreeNode> root) const
+{
+	Classifier classifier(_base, _radius, std::move(root));
+	const QRectF rect = _base.bounds();
+	std::vector<std::pair<qint64, qint64>> rows(GRID);
+	for (int j = 0; j < GRID; ++ j) rows[j].first = j;
+
+	//Строка сетки: число точек в круге и сумма их глубин
+	QtConcurrent::blockingMap(rows, [&](std::pair<qint64, qint64> &row) {
+		TRACE_SPAN("EarlyExit::depth");
+		qreal y = rect.top() + (row.first + .5) * rect.height() / GRID;
+		qint64 count = 0, depth = 0;
+		for (int i = 0; i < GRID; ++ i) {
+			QPointF p(rect.left() + (i + .5) * rect.width() / GRID, y);
+			if (!_base.contains(p)) continue;
+			++ count;
+			depth += classifier.classify(p)._depth;
+		}
+		row = {count, depth};
+	});
+	qint64 count = 0, depth = 0;
+	for (const auto &row : rows) {
+		count += row.first;
+		depth += row.second;
+	}
+	return count? qreal(depth) / count: 0.;
+}
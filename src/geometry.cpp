@@ -0,0 +1,286 @@
+#include <geometry.hpp>
+#include <QtMath>
+#include <random>
+
+Cell::Cell(const Disk &base): _base(base)
+{
+	_bounds.push_back(base.bounds());
+}
+
+void Cell::push(const Disk &disk, bool inside)
+{
+	_parts.push_back({disk, inside});
+	QRectF bounds = _bounds.back();
+	if (inside) {
+		bounds = bounds.intersected(disk.bounds());
+	}
+	_bounds.push_back(bounds);
+}
+
+void Cell::pop()
+{
+	_parts.pop_back();
+	_bounds.pop_back();
+}
+
+bool Cell::contains(const QPointF &point) const
+{
+	//Последние ограничения самые узкие, проверяем их первыми
+	for (auto it = _parts.rbegin(); it != _parts.rend(); ++ it) {
+		if (it->_disk.contains(point) != it->_inside) return false;
+	}
+	return _base.contains(point);
+}
+
+bool Cell::contains(const QPointF &point, qreal epsilon) const
+{
+	auto fits = [&point, epsilon](const Disk &disk, bool inside) {
+		QPointF d = point - disk._center;
+		qreal q = QPointF::dotProduct(d, d);
+		if (inside) {
+			qreal r = disk._radius + epsilon;
+			return q <= r * r;
+		}
+		qreal r = std::max(disk._radius - epsilon, 0.);
+		return q >= r * r;
+	};
+	for (auto it = _parts.rbegin(); it != _parts.rend(); ++ it) {
+		if (!fits(it->_disk, it->_inside)) return false;
+	}
+	return fits(_base, true);
+}
+
+qreal Cell::area(int resolution) const
+{
+	const QRectF &rect = bounds();
+	if (rect.isEmpty()) return 0.;
+	qreal dx = rect.width() / resolution;
+	qreal dy = rect.height() / resolution;
+	int count = 0;
+	for (int i = 0; i < resolution; ++ i) {
+		for (int j = 0; j < resolution; ++ j) {
+			QPointF p(rect.left() + (i + .5) * dx,
+			          rect.top() + (j + .5) * dy);
+			count += contains(p);
+		}
+	}
+	return count * dx * dy;
+}
+
+std::vector<QPointF> Cell::samples(int resolution) const
+{
+	std::vector<QPointF> points;
+	const QRectF &rect = bounds();
+	if (rect.isEmpty()) return points;
+	qreal dx = rect.width() / resolution;
+	qreal dy = rect.height() / resolution;
+	for (int i = 0; i < resolution; ++ i) {
+		for (int j = 0; j < resolution; ++ j) {
+			QPointF p(rect.left() + (i + .5) * dx,
+			          rect.top() + (j + .5) * dy);
+			if (contains(p)) points.push_back(p);
+		}
+	}
+	return points;
+}
+
+bool Cell::arcs(const std::function<bool(const Disk&, qreal, qreal)> &visit) const
+{
+	if (bounds().isEmpty()) return true;
+
+	//Ячейка ограничена дугами своих окружностей. Участок окружности
+	//между соседними пересечениями лежит на границе целиком, если его
+	//середина строго удовлетворяет всем остальным ограничениям
+	std::vector<Part> parts(_parts);
+	parts.push_back({_base, true});
+	const int size = parts.size();
+	auto strict = [](const Part &part, const QPointF &point) {
+		QPointF d = point - part._disk._center;
+		qreal q = std::sqrt(QPointF::dotProduct(d, d));
+		qreal eps = 1.e-9 * std::max(part._disk._radius, 1.);
+		return part._inside? (q < part._disk._radius - eps):
+		                     (q > part._disk._radius + eps);
+	};
+	auto same = [](const Disk &a, const Disk &b) {
+		qreal eps = 1.e-9 * std::max(a._radius, 1.);
+		return (std::abs(a._radius - b._radius) < eps) &&
+		       (std::abs(a._center.x() - b._center.x()) < eps) &&
+		       (std::abs(a._center.y() - b._center.y()) < eps);
+	};
+	for (int k = 0; k < size; ++ k) {
+		const Disk &disk = parts[k]._disk;
+		if (disk._radius <= 0.) continue;
+		std::vector<qreal> angles;
+		std::vector<bool> skip(size, false);
+		skip[k] = true;
+		for (int j = 0; j < size; ++ j) {
+			if (j == k) continue;
+			if (same(disk, parts[j]._disk)) {
+				//Совпадающая окружность: либо дублирует ограничение, либо
+				//требует противоположной стороны и ячейка пуста
+				if (parts[j]._inside != parts[k]._inside) return true;
+				skip[j] = true;
+				continue;
+			}
+			for (const auto &p : intersect(disk._center, disk._radius,
+			                               parts[j]._disk._center, parts[j]._disk._radius)) {
+				angles.push_back(std::atan2(p.y() - disk._center.y(),
+				                            p.x() - disk._center.x()));
+			}
+		}
+		std::sort(angles.begin(), angles.end());
+		if (angles.empty()) angles.push_back(0.);
+		for (size_t i = 0; i < angles.size(); ++ i) {
+			qreal a = angles[i];
+			qreal b = (i + 1 < angles.size())? angles[i + 1]: angles.front() + 2 * M_PI;
+			if (b - a < 1.e-12) continue;
+			qreal m = (a + b) / 2;
+			QPointF point = disk._center + disk._radius * QPointF(std::cos(m), std::sin(m));
+			bool boundary = true;
+			for (int j = 0; boundary && (j < size); ++ j) {
+				if (!skip[j] && !strict(parts[j], point)) boundary = false;
+			}
+			if (boundary && !visit(disk, a, b)) return false;
+		}
+	}
+	return true;
+}
+
+bool Cell::isEmpty() const
+{
+	//Ячейка имеет площадь, только если у нее есть хотя бы одна дуга границы
+	return arcs([](const Disk&, qreal, qreal) { return false; });
+}
+
+bool Cell::isInside(const Disk &disk) const
+{
+	if (isEmpty()) return true;
+	qreal limit = disk._radius * (1. + 1.e-9);
+	auto inside = [&](const QPointF &p) {
+		return std::hypot(p.x() - disk._center.x(), p.y() - disk._center.y()) <= limit;
+	};
+	//Дальняя от центра круга точка дуги - один из ее концов либо
+	//точка окружности в направлении от центра круга
+	return arcs([&](const Disk &arc, qreal a, qreal b) {
+		auto at = [&arc](qreal t) {
+			return arc._center + arc._radius * QPointF(std::cos(t), std::sin(t));
+		};
+		if (!inside(at(a)) || !inside(at(b))) return false;
+		QPointF d = arc._center - disk._center;
+		qreal apex = std::atan2(d.y(), d.x());
+		while (apex < a) apex += 2 * M_PI;
+		return (apex > b) || inside(at(apex));
+	});
+}
+
+std::vector<QPointF> intersect(const QPointF &c1, qreal r1, const QPointF &c2, qreal r2)
+{
+	qreal x1 = c1.x(), x2 = c2.x(), y1 = c1.y(), y2 = c2.y();
+	qreal dx = x2 - x1;
+	qreal dy = y2 - y1;
+	qreal dq = dx * dx + dy * dy, d = std::sqrt(dq);
+	if ((d < std::abs(r2 - r1) + 1.e-7) ||
+	    (d > r1 + r2 + 1.e-7)) {
+		return {};
+	}
+	dx = dx / d; dy = dy / d;
+	qreal nx = - dy;
+	qreal ny = dx;
+	qreal a = (r1 * r1 - r2 * r2 + dq) / (2 * d);
+	qreal h = std::sqrt(r1 * r1 - a * a);
+	qreal x0 = x1 + a * dx;
+	qreal y0 = y1 + a * dy;
+	x1 = x0 + h * nx;
+	y1 = y0 + h * ny;
+	x2 = x0 - h * nx;
+	y2 = y0 - h * ny;
+	if (std::abs(h) > 1.e-7) {
+		return {
+			QPointF(x1, y1),
+			QPointF(x2, y2)
+		};
+	}
+	return {
+		QPointF(x1, y1)
+	};
+}
+
+void intersectAll(const std::vector<Disk> &disks,
+                  const std::function<void(int, int, const std::vector<QPointF>&)> &report)
+{
+	std::vector<int> order(disks.size());
+	for (size_t i = 0; i < order.size(); ++ i) order[i] = i;
+	std::sort(order.begin(), order.end(), [&disks](int a, int b) {
+		return disks[a]._center.x() - disks[a]._radius <
+		       disks[b]._center.x() - disks[b]._radius;
+	});
+
+	//Активны окружности, чей габарит еще пересекает линию развертки
+	std::vector<int> active;
+	for (int i : order) {
+		const auto &a = disks[i];
+		qreal left = a._center.x() - a._radius;
+		active.erase(std::remove_if(active.begin(), active.end(), [&](int j) {
+			return disks[j]._center.x() + disks[j]._radius < left - 1.e-7;
+		}), active.end());
+		for (int j : active) {
+			const auto &b = disks[j];
+			if (std::abs(a._center.y() - b._center.y()) > a._radius + b._radius + 1.e-7) {
+				continue;
+			}
+			auto res = intersect(a._center, a._radius, b._center, b._radius);
+			if (!res.empty()) report(i, j, res);
+		}
+		active.push_back(i);
+	}
+}
+
+Disk enclose(std::vector<QPointF> points)
+{
+	if (points.empty()) return {QPointF(), 0.};
+
+	//Перемешивание дает ожидаемое линейное время, зерно постоянно ради повторяемости
+	std::mt19937 random(points.size());
+	std::shuffle(points.begin(), points.end(), random);
+
+	auto inside = [](const Disk &disk, const QPointF &p) {
+		QPointF d = p - disk._center;
+		return QPointF::dotProduct(d, d) <= disk._radius * disk._radius * (1. + 1e-12);
+	};
+	auto pair = [](const QPointF &a, const QPointF &b) {
+		return Disk{(a + b) / 2., std::hypot(a.x() - b.x(), a.y() - b.y()) / 2.};
+	};
+	auto triple = [&](const QPointF &a, const QPointF &b, const QPointF &c) {
+		qreal bx = b.x() - a.x(), by = b.y() - a.y();
+		qreal cx = c.x() - a.x(), cy = c.y() - a.y();
+		qreal d = 2. * (bx * cy - by * cx);
+		if (std::abs(d) < 1e-18) {
+			//Точки на одной прямой: круг на самой дальней паре
+			Disk best = pair(a, b);
+			for (const Disk &next : {pair(a, c), pair(b, c)}) {
+				if (next._radius > best._radius) best = next;
+			}
+			return best;
+		}
+		qreal bq = bx * bx + by * by, cq = cx * cx + cy * cy;
+		qreal ux = (cy * bq - by * cq) / d;
+		qreal uy = (bx * cq - cx * bq) / d;
+		return Disk{a + QPointF(ux, uy), std::hypot(ux, uy)};
+	};
+
+	Disk disk{points.front(), 0.};
+	for (size_t i = 1; i < points.size(); ++ i) {
+		if (inside(disk, points[i])) continue;
+		disk = {points[i], 0.};
+		for (size_t j = 0; j < i; ++ j) {
+			if (inside(disk, points[j])) continue;
+			disk = pair(points[i], points[j]);
+			for (size_t k = 0; k < j; ++ k) {
+				if (!inside(disk, points[k])) {
+					disk = triple(points[i], points[j], points[k]);
+				}
+			}
+		}
+	}
+	return disk;
+}
@@ -1,40 +1,11 @@
 #include <graphicsscene.hpp>
 #include <QMessageBox>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
-
-static std::vector<QPointF> intersect(const QPointF &c1, qreal r1, const QPointF &c2, qreal r2)
-{
-	qreal x1 = c1.x(), x2 = c2.x(), y1 = c1.y(), y2 = c2.y();
-	qreal dx = x2 - x1;
-	qreal dy = y2 - y1;
-	qreal dq = dx * dx + dy * dy, d = std::sqrt(dq);
-	if ((d < std::abs(r2 - r1) + 1.e-7) ||
-	    (d > r1 + r2 + 1.e-7)) {
-		return {};
-	}
-	dx = dx / d; dy = dy / d;
-	qreal nx = - dy;
-	qreal ny = dx;
-	qreal a = (r1 * r1 - r2 * r2 + dq) / (2 * d);
-	qreal h = std::sqrt(r1 * r1 - a * a);
-	qreal x0 = x1 + a * dx;
-	qreal y0 = y1 + a * dy;
-	x1 = x0 + h * nx;
-	y1 = y0 + h * ny;
-	x2 = x0 - h * nx;
-	y2 = y0 - h * ny;
-	if (std::abs(h) > 1.e-7) {
-		return {
-			QPointF(x1, y1),
-			QPointF(x2, y2)
-		};
-	}
-	return {
-		QPointF(x1, y1)
-	};
-}
+#include <treefile.hpp>
+#include <verifier.hpp>
+#include <simplifier.hpp>
+#include <margins.hpp>
+#include <earlyexit.hpp>
+#include <trace.hpp>
 
 static std::vector<QPointF> place(const QPointF &p1, const QPointF &p2, qreal r)
 {
@@ -71,6 +42,13 @@ const std::vector<QColor> GraphicsScene::CircleItem::_colors = {
 
 GraphicsScene::GraphicsScene(QObject *parent):
     QGraphicsScene(parent) {
+	_frame.setSingleShot(true);
+	_frame.setInterval(16);
+	connect(&_frame, &QTimer::timeout, this, &GraphicsScene::flush);
+	connect(&_heat, &HeatMap::imageReady, this, &GraphicsScene::showHeat);
+	_heatDelay.setSingleShot(true);
+	_heatDelay.setInterval(200);
+	connect(&_heatDelay, &QTimer::timeout, this, &GraphicsScene::renderHeat);
 }
 
 GraphicsScene::~GraphicsScene()
@@ -89,101 +67,71 @@ QPointF GraphicsScene::pointToScene(const QPointF& point) const
 	return _center + _scale * p;
 }
 
-void GraphicsScene::parse(TreeNode *node, int index, const QJsonObject &object)
-{
-	auto center = object["center"].toArray();
-	auto x = center[0].toDouble();
-	auto y = center[1].toDouble();
-	node->_center = QPointF(x, y);
-	node->_circle = _indexToCircle.at(index);
-	auto branch = object["branch"].toArray();
-	for (int i = 0; i < std::min(2, int(branch.size())); ++i) {
-		auto obj = branch[i].toObject();
-		if (!obj.empty()) {
-			auto next = std::make_shared<TreeNode>();
-			parse(next.get(), index + 1, obj);
-			node->_branch[i] = next;
-			next->_fixed = true;
-		}
+bool GraphicsScene::loadFromFile(QFile *file)
+{
+	TRACE_SPAN("GraphicsScene::loadFromFile");
+	TreeDocument doc;
+	QString error;
+	if (!TreeFile::read(file, doc, nullptr, &error)) {
+		if (_monitor)
+			_monitor->sendError(error);
+		return false;
 	}
-	node->_fixed = true;
+	setDocument(std::move(doc));
+
+	return true;
 }
 
-bool GraphicsScene::loadFromFile(QFile *file)
+bool GraphicsScene::saveToFile(QFile *file) const
 {
-	QByteArray data = file->readAll();
-
-	QJsonDocument doc(QJsonDocument::fromJson(data));
-	clear();
-	QJsonObject obj = doc.object();
-	QJsonArray rad = obj["radius"].toArray();
-	for (auto r: rad) {
-		addCircle({0., 0.}, r.toDouble());
-	}
-	obj = obj["search"].toObject();
-	_treeRoot = std::make_shared<TreeNode>();
-	parse(_treeRoot.get(), 1, obj);
-	if (_mode == Mode::Free)
-		_mode = Mode::Tree;
-	start();
+	TRACE_SPAN("GraphicsScene::saveToFile");
+	if (!_treeRoot) return false;
 
-	return true;
+	return TreeFile::write(file, getDocument());
 }
 
-void GraphicsScene::convert(TreeNode *node, QJsonObject &object) const
+TreeDocument GraphicsScene::getDocument() const
 {
-	object["center"] = QJsonArray(
-	    {node->_center.x(), node->_center.y()}
-	);
-	std::array<QJsonObject, 2> branch;
-	for (int i = 0; i < 2; ++i) {
-		auto *next = node->_branch[i].get();
-		if (next) {
-			convert(next, branch[i]);
-		}
+	TreeDocument doc;
+	doc._radius = getRadius();
+	if (_treeRoot) {
+		doc._root = _treeRoot->clone();
 	}
-	object["branch"] = QJsonArray(
-	    {branch[0], branch[1]}
-	);
+	return doc;
 }
 
-bool GraphicsScene::saveToFile(QFile *file) const
+void GraphicsScene::setDocument(TreeDocument doc)
 {
-	if (!_treeRoot) return false;
-
-	QJsonArray radius;
-	for (auto [index, circle] : _indexToCircle) {
-		radius.append(circle->getRadius());
-	}
-	QJsonObject object;
-	object["radius"] = radius;
-	QJsonObject branch;
-	convert(
-	    _treeRoot.get(),
-	    branch
-	);
-	object["search"] =
-	    branch;
-
-	file->write(
-	    QJsonDocument(object).toJson(
-	    QJsonDocument::Compact
-	    )
-	);
-	return true;
+	clear();
+	for (auto r: doc._radius) {
+		addCircle({0., 0.}, r);
+	}
+	_treeRoot = std::move(doc._root);
+	if (_treeRoot) _stats.addTree(_treeRoot.get(), 0, _indexToCircle.size());
+	if (_mode == Mode::Free)
+		_mode = Mode::Tree;
+	start();
 }
 
 void GraphicsScene::check(TreeNode *node, std::string &path, std::vector<std::string> &result) const
 {
-	if (!node || (path.size() == _circles.size() - 2)) return;
+	//Решенные поддеревья не содержат открытых путей
+	if (!node || (node->_status == TreeNode::Solved)) return;
 
+	if (path.size() == _circles.size() - 2) {
+		if (node->_status == TreeNode::Failed) {
+			result.push_back(path + " !");
+		}
+		return;
+	}
 	for (int i = 0; i < 2; ++i) {
 		path += '0' + i;
 		auto* next = node->_branch[i].get();
 		if (next) {
 			check(next, path, result);
 		}
-		else {
+		else
+		if (!node->_empty[i]) {
 			int n = _circles.size() - 2;
 			result.push_back(path);
 			auto &s = result.back();
@@ -198,6 +146,7 @@ void GraphicsScene::check(std::vector<std::string> &result) const
 	result.clear();
 	if (!_treeRoot) return;
 
+	verify();
 	auto node = _treeRoot;
 	std::string path;
 	check(
@@ -206,8 +155,211 @@ void GraphicsScene::check(std::vector<std::string> &result) const
 	);
 }
 
+TreeNode::Status GraphicsScene::verify(qreal *uncovered) const
+{
+	if (!_treeRoot || (_indexToCircle.size() < 2)) return TreeNode::Open;
+
+	Verifier verifier(getBase(), getRadius());
+	auto status = verifier.verify(_treeRoot.get());
+	if (uncovered) *uncovered = _treeRoot->_uncovered;
+	return status;
+}
+
+qint64 GraphicsScene::simplify()
+{
+	Recorder::Entry entry(_recorder, Recorder::Simplify);
+
+	if (!_treeRoot || (_indexToCircle.size() < 2)) return 0;
+
+	syncCenter();
+	Simplifier simplifier(getBase(), getRadius());
+	qint64 removed = simplifier.simplify(_treeRoot.get());
+	++ _revision;
+	if (removed) {
+		qint64 pending = _stats._pending;
+		_stats = TreeStats();
+		_stats.addTree(_treeRoot.get(), 0, _indexToCircle.size());
+		_stats._pending = pending;
+	}
+	//Пустые ячейки в журнал не пишутся, сворачиваем его в полное сохранение
+	if (_journal && removed) _journal->requestCompaction();
+	if (_mode == Mode::Tree) start();
+	return removed;
+}
+
+qint64 GraphicsScene::earlyExit(qreal *before, qreal *after)
+{
+	Recorder::Entry entry(_recorder, Recorder::Exits);
+
+	if (!_treeRoot || (_indexToCircle.size() < 2)) return 0;
+
+	syncCenter();
+	EarlyExit early(getBase(), getRadius());
+	if (before) *before = early.expectedDepth(_treeRoot);
+	auto exits = early.analyze(_treeRoot.get());
+	early.rewrite(_treeRoot.get(), exits);
+	if (after) *after = early.expectedDepth(_treeRoot);
+	++ _revision;
+	if (!exits.empty()) {
+		qint64 pending = _stats._pending;
+		_stats = TreeStats();
+		_stats.addTree(_treeRoot.get(), 0, _indexToCircle.size());
+		_stats._pending = pending;
+	}
+	//Ранние выходы в журнал не пишутся, сворачиваем его в полное сохранение
+	if (_journal && !exits.empty()) _journal->requestCompaction();
+	if (_mode == Mode::Tree) start();
+	return exits.size();
+}
+
+qreal GraphicsScene::measure()
+{
+	if (!_treeRoot || (_indexToCircle.size() < 2)) {
+		return std::numeric_limits<qreal>::infinity();
+	}
+	syncCenter();
+	Margins margins(getBase(), getRadius());
+	return margins.measure(_treeRoot.get());
+}
+
+void GraphicsScene::weakest(const TreeNode *node, std::string &path,
+                            std::vector<std::pair<qreal, std::string>> &leaves) const
+{
+	if (std::isnan(node->_margin) || std::isinf(node->_margin)) return;
+	if (node->_index + 1 >= int(_indexToCircle.size())) {
+		//Отказавшие листья уже перечислены проверкой
+		if (node->_margin >= 0.) leaves.emplace_back(node->_margin, path);
+		return;
+	}
+	for (int i = 0; i < 2; ++ i) {
+		auto *next = node->_branch[i].get();
+		if (!next) continue;
+		path += '0' + i;
+		weakest(next, path, leaves);
+		path.pop_back();
+	}
+}
+
+void GraphicsScene::weakest(std::vector<std::string> &result, int count) const
+{
+	result.clear();
+	if (!_treeRoot) return;
+
+	std::vector<std::pair<qreal, std::string>> leaves;
+	std::string path;
+	weakest(_treeRoot.get(), path, leaves);
+	count = std::min<int>(count, leaves.size());
+	std::partial_sort(leaves.begin(), leaves.begin() + count, leaves.end());
+	for (int i = 0; i < count; ++ i) {
+		result.push_back(leaves[i].second + " ~ " +
+		                 QByteArray::number(leaves[i].first, 'g', 3).toStdString());
+	}
+}
+
+Disk GraphicsScene::getBase() const
+{
+	auto *base = _indexToCircle.at(0);
+	return {base->getCenter(), base->getRadius()};
+}
+
+std::vector<qreal> GraphicsScene::getRadius() const
+{
+	std::vector<qreal> radius;
+	for (auto [index, circle] : _indexToCircle) {
+		radius.push_back(circle->getRadius());
+	}
+	return radius;
+}
+
+std::vector<QPointF> GraphicsScene::getPathCenters() const
+{
+	std::vector<QPointF> centers;
+	if (!_treeNode) return centers;
+	for (const auto &node : _treePath) {
+		centers.push_back(circleOf(node.get())->getCenter());
+	}
+	centers.push_back(circleOf(_treeNode.get())->getCenter());
+	return centers;
+}
+
+void GraphicsScene::restorePath(const std::string &path, const std::vector<QPointF> &centers)
+{
+	if ((_mode != Mode::Tree) || centers.empty() || (centers.size() > path.size() + 1)) {
+		return;
+	}
+	start();
+	//Сохраненные узлы получают свои же центры, новые - записанные
+	for (size_t i = 0; i < centers.size(); ++ i) {
+		if (i && !goToNext(path[i - 1] == '1')) break;
+		placeToPoint(centers[i]);
+	}
+	flush();
+}
+
+void GraphicsScene::syncCenter()
+{
+	//Режим проверки двигает окружности только для показа, в модель их не пишем
+	if (!_treeNode || (_mode == Mode::Test)) return;
+
+	//Смещение окружности меняет ячейки всех потомков узла
+	const auto &center = circleOf(_treeNode.get())->getCenter();
+	if (center == _treeNode->_center) return;
+	_treeNode->_center = center;
+	_treeNode->invalidate();
+	//Пустота ветвей подтверждена для прежних ячеек
+	clearEmpty(_treeNode.get(), _treePath.size(), isAttached());
+	invalidatePath();
+	if (_journal && isAttached()) {
+		_journal->center(nodePath(), center);
+	}
+}
+
+void GraphicsScene::clearEmpty(TreeNode *node, int depth, bool attached)
+{
+	if (node->_empty[0] || node->_empty[1]) {
+		const int levels = _indexToCircle.size();
+		if (attached) _stats.add(node, depth, levels, -1);
+		node->_empty = {false, false};
+		if (attached) _stats.add(node, depth, levels);
+	}
+	for (auto &next : node->_branch) {
+		if (next) clearEmpty(next.get(), depth + 1, attached);
+	}
+}
+
+int GraphicsScene::attachedCount() const
+{
+	if (!_treeNode || !_treeRoot) return 0;
+	const int size = _treePath.size();
+	auto at = [&](int i) { return (i < size)? _treePath[i]: _treeNode; };
+	if (at(0) != _treeRoot) return 0;
+	int count = 1;
+	while ((count <= size) &&
+	       (at(count - 1)->_branch[_textPath[count - 1] == '1'] == at(count))) {
+		++ count;
+	}
+	return count;
+}
+
+void GraphicsScene::updatePending()
+{
+	_stats._pending = _treeNode? int(_treePath.size()) + 1 - attachedCount(): 0;
+}
+
+void GraphicsScene::invalidatePath()
+{
+	++ _revision;
+	if (_treeNode) _treeNode->reset();
+	for (auto &node : _treePath) {
+		node->reset();
+	}
+}
+
 bool GraphicsScene::test(const QPointF &point)
 {
+	TRACE_SPAN("GraphicsScene::test");
+	Recorder::Entry entry(_recorder, Recorder::Test, point);
+
 	if (_mode != Mode::Test) return false;
 
 	if (_indexToCircle.empty() || !_indexToCircle.at(0)->containsPoint(point)) {
@@ -221,7 +373,7 @@ bool GraphicsScene::test(const QPointF &point)
 	CircleItem *circ = nullptr;
 	_treeNode = _treeRoot;
 	while (_treeNode) {
-		auto center = _treeNode->_center; circ = _treeNode->_circle;
+		auto center = _treeNode->_center; circ = circleOf(_treeNode.get());
 		circ->setCenter(center);
 		int ans = circ->containsPoint(point);
 		circ->setVisible(true);
@@ -245,11 +397,24 @@ bool GraphicsScene::test(const QPointF &point)
 
 void GraphicsScene::setMode(Mode mode)
 {
+	Recorder::Entry entry(_recorder, Recorder::Mode, qint32(mode));
+
 	_circle = nullptr;
 	_knot1 = nullptr;
 	_knot2 = nullptr;
 	if ((_mode == Mode::Test) && (mode == Mode::Tree) &&
 	    (_treeNode != _treeRoot)) {
+		//Предпросмотр под курсором мог сдвинуть окружности пути
+		std::map<int, const TreeNode*> used;
+		for (const auto &node : _treePath) used[node->_index] = node.get();
+		used[_treeNode->_index] = _treeNode.get();
+		for (const auto &circle : _circles) {
+			if (circle->getIndex() < 1) continue;
+			auto it = used.find(circle->getIndex());
+			if (it != used.end()) circle->setCenter(it->second->_center);
+			circle->setVisible(it != used.end());
+		}
+		_hoverValid = false;
 		_mode = mode;
 		updateKnots();
 		return;
@@ -265,6 +430,8 @@ void GraphicsScene::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *mouseEvent)
 
 void GraphicsScene::mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent)
 {
+	flush();
+
 	//Производим захват объекта
 	const auto &scenePos = mouseEvent->scenePos();
 	auto point = pointFromScene(scenePos);
@@ -273,43 +440,14 @@ void GraphicsScene::mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent)
 		auto *circle = dynamic_cast<CircleItem*>(item);
 		auto *knot = dynamic_cast<KnotItem*>(item);
 		if (circle && circle->isEnabled()) {
-			_circle = circle;
-			if (_knot1 && _knot2) {
-				_knot1 = nullptr;
-				_knot2 = nullptr;
-			}
-			_prev = point;
-			update();
+			grabCircle(circle->getIndex(), point);
 			return;
 		}
 		if (knot) {
-			if (_knot2 == knot) {
-				_knot2 = nullptr;
-			}
-			else
-			if (_knot1 == knot) {
-				_knot1 = _knot2;
-				_knot2 = nullptr;
-			}
-			else
-			if (_knot2) {
-				_knot1 = knot;
-				_knot2 = nullptr;
-			}
-			else
-			if (_knot1) {
-				_knot2 = knot;
-			}
-			else {
-				_knot1 = knot;
-			}
-			updateKnots();
+			selectKnot(knot->getPoint());
 			return;
 		}
-		_circle = nullptr;
-		_knot1 = nullptr;
-		_knot2 = nullptr;
-		updateKnots();
+		dropSelection();
 	}
 	else {
 		test(point);
@@ -323,44 +461,179 @@ void GraphicsScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
 		auto point = pointFromScene(mouseEvent->scenePos());
 		_monitor->sendPosition(point, false);
 	}
-	if (_mode == Mode::Test) return;
+	if (_mode == Mode::Test) {
+		if (_hover) hover(pointFromScene(mouseEvent->scenePos()));
+		return;
+	}
 
+	//Смещения накапливаются до ближайшего кадра
 	if (_circle) {
 		auto point = pointFromScene(mouseEvent->scenePos());
-		auto off = point - _prev;
-		_circle->setCenter(_circle->getCenter() + off);
+		_drag += point - _prev;
 		_prev = point;
-		if (_knot1 && !_knot2) {
-			auto p1 = _knot1->getPoint();
-			auto c = _circle->getCenter();
-			auto r = _circle->getRadius();
-			qreal dx = c.x() - p1.x();
-			qreal dy = c.y() - p1.y();
-			qreal d = std::sqrt(dx * dx + dy * dy);
-			dx /= d; dy /= d;
-			c = QPointF(p1.x() + dx * r,
-			        p1.y() + dy * r);
-			_circle->setCenter(c);
-		}
-		updateKnots();
+		invalidate(Dirty::Clean);
 	}
 }
 
 void GraphicsScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
 {
-	_circle = nullptr;
-	update();
+	flush();
+	releaseCircle();
 }
 
 void GraphicsScene::wheelEvent(QGraphicsSceneWheelEvent *wheelEvent)
 {
 	constexpr qreal factor = 1.03125;
 
-	//Обновляем ЛСК
 	qreal f = ((wheelEvent->delta() < 0)? (1. / factor): factor);
+	zoom(wheelEvent->scenePos(), f);
+}
 
-	_center = (1 - f) * wheelEvent->scenePos() + f * _center;
-	_scale *= f;
+void GraphicsScene::grabCircle(int index, const QPointF &point)
+{
+	Recorder::Entry entry(_recorder, Recorder::Grab, qint32(index), point);
+
+	auto it = _indexToCircle.find(index);
+	if (it == _indexToCircle.end()) return;
+	_circle = it->second;
+	if (_knot1 && _knot2) {
+		_knot1 = nullptr;
+		_knot2 = nullptr;
+	}
+	_prev = point;
+
+	//Выборка ячейки строится один раз на все перетаскивание
+	_split.clear();
+	if ((_mode == Mode::Tree) && _treeNode && (_circle == circleOf(_treeNode.get()))) {
+		const int resolution = 2 * Cell::RESOLUTION;
+		Cell cell = currentCell();
+		const QRectF &rect = cell.bounds();
+		_split = cell.samples(resolution);
+		_splitWeight = rect.width() * rect.height() / (resolution * resolution);
+		_splitStep = std::hypot(rect.width(), rect.height()) / (2 * resolution);
+		measureSplit();
+	}
+	update();
+}
+
+void GraphicsScene::dragBy(const QPointF &off)
+{
+	Recorder::Entry entry(_recorder, Recorder::Drag, off);
+
+	if (!_circle) return;
+	_circle->setCenter(_circle->getCenter() + off);
+	if (_knot1 && !_knot2) {
+		auto p1 = _knot1->getPoint();
+		auto c = _circle->getCenter();
+		auto r = _circle->getRadius();
+		qreal dx = c.x() - p1.x();
+		qreal dy = c.y() - p1.y();
+		qreal d = std::sqrt(dx * dx + dy * dy);
+		dx /= d; dy /= d;
+		c = QPointF(p1.x() + dx * r,
+		        p1.y() + dy * r);
+		_circle->setCenter(c);
+	}
+	measureSplit();
+	updateKnots();
+}
+
+void GraphicsScene::measureSplit()
+{
+	TRACE_SPAN("GraphicsScene::measureSplit");
+	if (!_monitor || _split.empty() || !_circle) return;
+
+	//Выборка упорядочена по x: точки вне полосы окружности не проверяем
+	Disk disk{_circle->getCenter(), _circle->getRadius()};
+	qreal left = disk._center.x() - disk._radius;
+	qreal right = disk._center.x() + disk._radius;
+	auto first = std::partition_point(_split.begin(), _split.end(),
+	                                  [left](const QPointF &p) { return p.x() < left; });
+	auto last = std::partition_point(first, _split.end(),
+	                                 [right](const QPointF &p) { return p.x() <= right; });
+	_splitInside.clear();
+	for (auto it = first; it != last; ++ it) {
+		if (disk.contains(*it)) _splitInside.push_back(*it);
+	}
+	qreal inside = _splitInside.size() * _splitWeight;
+	qreal outside = (_split.size() - _splitInside.size()) * _splitWeight;
+
+	//Внутренняя часть накрыта, если помещается в последнюю окружность
+	bool covered = true;
+	if (_circle->getIndex() + 1 >= int(_indexToCircle.size())) {
+		covered = (_splitInside.size() == _split.size());
+	}
+	else
+	if (!_splitInside.empty()) {
+		qreal r = _indexToCircle.rbegin()->second->getRadius();
+		covered = (enclose(_splitInside)._radius + _splitStep <= r);
+	}
+	_monitor->sendSplit(inside, outside, covered);
+}
+
+void GraphicsScene::releaseCircle()
+{
+	Recorder::Entry entry(_recorder, Recorder::Release);
+
+	_circle = nullptr;
+	_split.clear();
+	update();
+}
+
+void GraphicsScene::selectKnot(const QPointF &point)
+{
+	Recorder::Entry entry(_recorder, Recorder::Knot, point);
+
+	KnotItem *knot = nullptr;
+	for (auto *k : _knots) {
+		const auto &p = k->getPoint();
+		if (std::max(std::abs(p.x() - point.x()),
+		             std::abs(p.y() - point.y())) < 1.e-7) {
+			knot = k;
+			break;
+		}
+	}
+	if (!knot) return;
+	if (_knot2 == knot) {
+		_knot2 = nullptr;
+	}
+	else
+	if (_knot1 == knot) {
+		_knot1 = _knot2;
+		_knot2 = nullptr;
+	}
+	else
+	if (_knot2) {
+		_knot1 = knot;
+		_knot2 = nullptr;
+	}
+	else
+	if (_knot1) {
+		_knot2 = knot;
+	}
+	else {
+		_knot1 = knot;
+	}
+	updateKnots();
+}
+
+void GraphicsScene::dropSelection()
+{
+	Recorder::Entry entry(_recorder, Recorder::Drop);
+
+	_circle = nullptr;
+	_knot1 = nullptr;
+	_knot2 = nullptr;
+	updateKnots();
+}
+
+void GraphicsScene::zoom(const QPointF &pos, qreal factor)
+{
+	Recorder::Entry entry(_recorder, Recorder::Zoom, pos, factor);
+
+	//Обновляем ЛСК
+	_center = (1 - factor) * pos + factor * _center;
+	_scale *= factor;
 
 	update();
 }
@@ -370,6 +643,7 @@ GraphicsScene::CircleItem* GraphicsScene::addCircle(const QPointF& center, qreal
 	auto *circle = new CircleItem(_circles.size());
 	_indexToCircle[circle->getIndex()] = circle;
 	_circles.insert(circle);
+	adopt(circle);
 	addItem(circle);
 
 	circle->setCenter(center);
@@ -390,6 +664,7 @@ GraphicsScene::KnotItem* GraphicsScene::addKnot(const QPointF &point)
 {
 	auto *knot = new KnotItem();
 	_knots.insert(knot);
+	adopt(knot);
 	addItem(knot);
 
 	knot->setPoint(point);
@@ -410,62 +685,119 @@ void GraphicsScene::delKnot(const KnotItem* knot)
 
 void GraphicsScene::updateKnots()
 {
-	std::vector<KnotItem*> knotsToDelete;
-	knotsToDelete.reserve(_knots.size());
-	for (const auto &knot : _knots) {
-		if ((knot != _knot1) && (knot != _knot2)) {
-			knotsToDelete.push_back(knot);
-		}
+	TRACE_SPAN("GraphicsScene::updateKnots");
+	invalidate(Dirty::Knots);
+}
+
+void GraphicsScene::update()
+{
+	TRACE_SPAN("GraphicsScene::update");
+	invalidate(Dirty::Items);
+}
+
+void GraphicsScene::invalidate(int dirty)
+{
+	//Перестроение выполняется не чаще одного раза за кадр
+	_dirty |= dirty;
+	if (!_frame.isActive()) _frame.start();
+}
+
+void GraphicsScene::flush()
+{
+	TRACE_SPAN("GraphicsScene::flush");
+	if (!_drag.isNull()) {
+		auto off = _drag;
+		_drag = QPointF();
+		dragBy(off);
 	}
-	for (const auto &knot: knotsToDelete) {
-		_knots.erase(knot);
-		removeItem(knot);
-		delete knot;
+	//Сдвиг снова помечает сцену, таймер гасим после разбора отметок
+	int dirty = _dirty;
+	_dirty = Dirty::Clean;
+	_frame.stop();
+	if (dirty & Dirty::Knots) {
+		rebuildKnots();
 	}
-	if (_mode == Mode::Test ||
-	    !_visibleKnots) {
-		update();
-		return;
+	else
+	if (dirty & Dirty::Items) {
+		redraw();
+	}
+}
+
+Cell GraphicsScene::currentCell() const
+{
+	Cell cell(getBase());
+	for (size_t i = 0; i < _treePath.size(); ++ i) {
+		auto *circle = _indexToCircle.at(i + 1);
+		cell.push({circle->getCenter(), circle->getRadius()}, _textPath[i] == '1');
 	}
+	return cell;
+}
 
-	for (auto it1 = _circles.begin(); it1 != _circles.end(); ++it1) {
-		if (!(*it1)->isVisible()) continue;	//Пропускаем скрытые окружности!
-		const auto& c1 = (*it1)->getCenter();
-		qreal r1 = (*it1)->getRadius();
-		for (auto it2 = _circles.begin(); it2 != it1; ++it2) {
-			if (!(*it2)->isVisible()) continue;	//Пропускаем скрытые окружности!
-			const auto& c2 = (*it2)->getCenter();
-			qreal r2 = (*it2)->getRadius();
-			auto res = intersect(c1, r1, c2, r2);
-			for (const auto& p: res) {
-				if (_knot1) {
-					const auto &p1 = _knot1->getPoint();
-					qreal dx1 = std::abs(p.x() - p1.x());
-					qreal dy1 = std::abs(p.y() - p1.y());
-					if (std::max(dx1, dy1) < 1.e-7) {
-						continue;
-					}
-				}
-				if (_knot2) {
-					const auto &p2 = _knot2->getPoint();
-					qreal dx2 = std::abs(p.x() - p2.x());
-					qreal dy2 = std::abs(p.y() - p2.y());
-					if (std::max(dx2, dy2) < 1.e-7) {
-						continue;
-					}
+void GraphicsScene::rebuildKnots()
+{
+	TRACE_SPAN("GraphicsScene::rebuildKnots");
+	//Невыбранные узлы переиспользуются для новых точек
+	std::vector<KnotItem*> pool;
+	pool.reserve(_knots.size());
+	for (const auto &knot : _knots) {
+		if ((knot != _knot1) && (knot != _knot2)) {
+			pool.push_back(knot);
+		}
+	}
+	std::vector<QPointF> points;
+	if (_mode != Mode::Test && _visibleKnots) {
+		//В режиме дерева нужны только узлы на границе текущей ячейки
+		constexpr qreal epsilon = 1.e-7;
+		bool tree = (_mode == Mode::Tree) && _treeNode;
+		Cell cell = tree? currentCell(): Cell(getBase());
+		QRectF bounds = cell.bounds().adjusted(-epsilon, -epsilon, epsilon, epsilon);
+		std::vector<Disk> disks;
+		disks.reserve(_circles.size());
+		for (const auto &circle : _circles) {
+			if (!circle->isVisible()) continue;	//Пропускаем скрытые окружности!
+			Disk disk{circle->getCenter(), circle->getRadius()};
+			if (tree && !disk.bounds().intersects(bounds)) continue;
+			disks.push_back(disk);
+		}
+		auto selected = [](const KnotItem *knot, const QPointF &p) {
+			if (!knot) return false;
+			const auto &q = knot->getPoint();
+			return std::max(std::abs(p.x() - q.x()),
+			                std::abs(p.y() - q.y())) < 1.e-7;
+		};
+		intersectAll(disks, [&](int, int, const std::vector<QPointF> &res) {
+			for (const auto &p : res) {
+				if (tree && !cell.contains(p, epsilon)) continue;
+				if (!selected(_knot1, p) && !selected(_knot2, p)) {
+					points.push_back(p);
 				}
-				addKnot(p);
 			}
+		});
+	}
+	for (size_t i = 0; i < points.size(); ++ i) {
+		if (i < pool.size()) {
+			pool[i]->setPoint(points[i]);
+		}
+		else {
+			addKnot(points[i]);
 		}
 	}
-	update();
+	for (size_t i = points.size(); i < pool.size(); ++ i) {
+		delKnot(pool[i]);
+	}
+	redraw();
 }
 
-void GraphicsScene::update()
+void GraphicsScene::redraw()
 {
+	TRACE_SPAN("GraphicsScene::redraw");
+	//Перестроение сцены меняет окружности, подсвеченные предпросмотром
+	_hoverValid = false;
+
 	//Обновляем текстовый путь в дереве
 	if (_monitor) {
 		_monitor->sendTreePath(_textPath.c_str(), _treeNode && _treeNode->_fixed);
+		_monitor->sendStats(_stats);
 	}
 
 	//Удаляем вспомогательные области
@@ -534,6 +866,7 @@ void GraphicsScene::update()
 					backCircle->setCenter(circle->getCenter());
 					backCircle->setRadius(circle->getRadius());
 					backCircle->setEnabled(false);
+					adopt(backCircle);
 					addItem(backCircle);
 					backCircle->setFilled(true);
 					backCircle->update();
@@ -555,7 +888,7 @@ void GraphicsScene::update()
 		circle->update();
 	}
 	if (_treeNode) {
-		_treeNode->_center = _treeNode->_circle->getCenter();
+		syncCenter();
 	}
 	//TODO: Перенести логику с раскрашиванием в класс узла!
 	//...
@@ -578,14 +911,224 @@ void GraphicsScene::update()
 		b.setColor(QColor(0, 0, 255));
 		knot->setBrush(b);
 	}
+	touchLayers();
+	refreshHeat();
+}
 
+void GraphicsScene::setBatchRendering(bool batch)
+{
+	if (batch == _batch) return;
+	_batch = batch;
+	if (batch) {
+		_back = new LayerItem(false);
+		_front = new LayerItem(true);
+		addItem(_back);
+		addItem(_front);
+	}
+	else {
+		for (auto *layer : {_back, _front}) {
+			removeItem(layer);
+			delete layer;
+		}
+		_back = _front = nullptr;
+	}
+	//Без отрисовки элементов индекс сцены не нужен
+	setItemIndexMethod(batch? QGraphicsScene::NoIndex: QGraphicsScene::BspTreeIndex);
+	for (auto *circle : _circles) adopt(circle);
+	for (auto *circle : _backCircles) adopt(circle);
+	for (auto *knot : _knots) adopt(knot);
+	update();
+}
+
+void GraphicsScene::paintLayer(QPainter *painter, bool front) const
+{
+	//Элементы уже хранят вычисленные перо, кисть и положение
+	auto draw = [painter](const QGraphicsEllipseItem *item) {
+		if (!item->isVisible()) return;
+		painter->setPen(item->pen());
+		painter->setBrush(item->brush());
+		painter->drawEllipse(item->rect().translated(item->pos()));
+	};
+	//Закрашенные окружности лежат под линиями, контуры и узлы над ними
+	if (!front) {
+		for (const auto *circle : _backCircles) draw(circle);
+	}
+	for (const auto *circle : _circles) {
+		if ((circle->zValue() > 0.) == front) draw(circle);
+	}
+	if (front) {
+		for (const auto *knot : _knots) draw(knot);
+	}
+}
+
+void GraphicsScene::setQuadTree(std::shared_ptr<const QuadTree> quadTree, quint64 revision)
+{
+	//Разбиение принимается, только если дерево с момента снимка не менялось.
+	//Сравниваем номер правки: отпечаток всего дерева в потоке окна дорог
+	if (revision != _revision) quadTree.reset();
+	_quadTree = std::move(quadTree);
+	_quadRevision = _revision;
+	_classifier.reset();
+	update();
+}
+
+void GraphicsScene::setHover(bool hover)
+{
+	_hover = hover;
+	if (!hover && _hoverValid && (_mode == Mode::Test)) start();
+}
+
+void GraphicsScene::hover(const QPointF &point)
+{
+	if (!_treeRoot || (_mode != Mode::Test) || (_indexToCircle.size() < 2)) return;
+
+	//Проходим модель без обращения к сцене
+	std::vector<std::pair<const TreeNode*, bool>> path;
+	std::string text(_circles.size() - 2, ANY);
+	bool covered = false;
+	const int last = int(_indexToCircle.size()) - 1;
+	if (_indexToCircle.at(0)->containsPoint(point)) {
+		const TreeNode *node = _treeRoot.get();
+		while (node) {
+			Disk disk{node->_center, circleOf(node)->getRadius()};
+			bool ans = disk.contains(point);
+			path.emplace_back(node, ans);
+			if (node->_index >= last) {
+				covered = ans;
+				break;
+			}
+			text[path.size() - 1] = '0' + ans;
+			node = node->_branch[ans].get();
+		}
+	}
+
+	//Соседние точки обычно проходят тем же путем: перерисовываем
+	//только окружности после первого расхождения
+	size_t common = 0;
+	if (_hoverValid) {
+		while ((common < path.size()) && (common < _hoverPath.size()) &&
+		       (path[common] == _hoverPath[common])) {
+			++ common;
+		}
+	}
+	//Узел раннего выхода ставит последнюю окружность, поэтому окружность
+	//берется по номеру узла, а не по месту в пути
+	std::vector<int> touched;
+	if (_hoverValid) {
+		for (size_t i = common; i < _hoverPath.size(); ++ i) {
+			touched.push_back(_hoverPath[i].first->_index);
+		}
+		for (size_t i = common; i < path.size(); ++ i) {
+			touched.push_back(path[i].first->_index);
+		}
+	}
+	else {
+		for (int i = 1; i <= last; ++ i) touched.push_back(i);
+	}
+	for (int index : touched) {
+		auto *circle = _indexToCircle.at(index);
+		auto it = std::find_if(path.begin(), path.end(), [index](const auto &entry) {
+			return entry.first->_index == index;
+		});
+		if (it != path.end()) {
+			circle->setCenter(it->first->_center);
+			circle->setOpaque(it->second);
+			circle->setVisible(true);
+			circle->update();
+		}
+		else {
+			circle->setVisible(false);
+		}
+	}
+	//Пакетные слои не узнают о смене видимости сами
+	if (!touched.empty()) touchLayers();
+	_hoverPath = std::move(path);
+	_hoverValid = true;
+	if (_monitor) _monitor->sendTreePath(text.c_str(), covered);
+}
+
+void GraphicsScene::setHeatMap(bool visible)
+{
+	if (visible == isHeatMap()) return;
+	if (!visible) {
+		removeItem(_heatItem);
+		delete _heatItem;
+		_heatItem = nullptr;
+		_classifier.reset();
+		_heatDelay.stop();
+		_heat.cancel();
+		return;
+	}
+	_heatItem = addPixmap(QPixmap());
+	_heatItem->setZValue(-2.);
+	_heatItem->setEnabled(false);
+	_heatView = QTransform();
+	update();
+}
+
+void GraphicsScene::refreshHeat()
+{
+	if (!_heatItem || _indexToCircle.size() < 2) return;
+
+	if (_classifier && (_heatRevision == _revision)) {
+		//Дерево не менялось: снимок готов, меняется только вид
+		QTransform view = heatView();
+		if (_heatView == view) return;
+		_heatView = view;
+		_heat.render(_classifier, sceneRect(), view);
+		return;
+	}
+	//Во время перетаскивания правка идет каждый кадр. Прежнюю карту
+	//оставляем на экране, а снимок дерева берем после паузы
+	_heat.cancel();
+	_heatDelay.start();
+}
+
+void GraphicsScene::renderHeat()
+{
+	if (!_heatItem || _indexToCircle.size() < 2) return;
+	_heatView = heatView();
+	_heat.render(snapshot(), sceneRect(), _heatView);
+}
+
+QTransform GraphicsScene::heatView() const
+{
+	//Перевод из координат сцены в координаты модели
+	return QTransform(1. / _scale, 0., 0., -1. / _scale,
+	                  -_center.x() / _scale, _center.y() / _scale);
+}
+
+std::shared_ptr<const Classifier> GraphicsScene::snapshot()
+{
+	if (_indexToCircle.size() < 2) return nullptr;
+	if (!_classifier || (_heatRevision != _revision)) {
+		std::shared_ptr<const TreeNode> root;
+		if (_treeRoot) root = _treeRoot->clone();
+		auto classifier = std::make_shared<Classifier>(getBase(), getRadius(), root);
+		if (_quadTree && (_quadRevision == _revision)) {
+			classifier->setQuadTree(_quadTree);
+		}
+		_classifier = classifier;
+		_heatRevision = _revision;
+	}
+	return _classifier;
+}
+
+void GraphicsScene::showHeat(const QImage &image, int generation)
+{
+	//Изображения прерванных построений отбрасываем
+	if (!_heatItem || (generation != _heat.getGeneration())) return;
+	_heatItem->setPixmap(QPixmap::fromImage(image));
+	_heatItem->setPos(sceneRect().topLeft());
 }
 
 bool GraphicsScene::placeToPoint(const QPointF &pos)
 {
+	Recorder::Entry entry(_recorder, Recorder::PlaceToPoint, pos);
+
 	if (_mode != Mode::Tree) return false;
 
-	_treeNode->_circle->setCenter(pos);
+	circleOf(_treeNode.get())->setCenter(pos);
 	updateKnots();
 
 	return true;
@@ -593,6 +1136,8 @@ bool GraphicsScene::placeToPoint(const QPointF &pos)
 
 bool GraphicsScene::placeToLocal(const QPointF &loc, bool inv)
 {
+	Recorder::Entry entry(_recorder, Recorder::PlaceToLocal, loc, inv);
+
 	if (_mode != Mode::Tree || !_knot1 || !_knot2) return false;
 
 	const auto &p1 = _knot1->getPoint(), &p2 = _knot2->getPoint();
@@ -607,7 +1152,7 @@ bool GraphicsScene::placeToLocal(const QPointF &loc, bool inv)
 	x0 += loc.x() * dx + loc.y() * nx;
 	y0 += loc.x() * dy + loc.y() * ny;
 
-	_treeNode->_circle->setCenter(
+	circleOf(_treeNode.get())->setCenter(
 	QPointF(x0, y0)
 	);
 	updateKnots();
@@ -616,9 +1161,11 @@ bool GraphicsScene::placeToLocal(const QPointF &loc, bool inv)
 
 bool GraphicsScene::placeToChord(bool inv)
 {
+	Recorder::Entry entry(_recorder, Recorder::PlaceToChord, inv);
+
 	if (_mode != Mode::Tree || !_knot1 && !_knot2) return false;
 
-	auto *c = _treeNode->_circle; qreal r = c->getRadius();
+	auto *c = circleOf(_treeNode.get()); qreal r = c->getRadius();
 	auto p1 = _knot1->getPoint();
 	if (_knot2) {
 		auto p2 = _knot2->getPoint();
@@ -643,17 +1190,20 @@ bool GraphicsScene::isFixedPath() const
 
 bool GraphicsScene::goToBack()
 {
+	TRACE_SPAN("GraphicsScene::goToBack");
+	Recorder::Entry entry(_recorder, Recorder::GoToBack);
+
 	if (_treePath.empty()) return false;
 
+	//Центр сохраняем, пока путь еще описывает покидаемый узел
+	syncCenter();
 	const auto prev = _treePath.back();
 	_treePath.pop_back();
 
-	auto *circle = _treeNode->_circle;
-	_treeNode->_center =
-	        circle->getCenter();
+	auto *circle = circleOf(_treeNode.get());
 	circle->setVisible(false);
 
-	circle = prev->_circle;
+	circle = circleOf(prev.get());
 	circle->setEnabled(true);
 	circle->setCenter(
 	    prev->_center
@@ -661,6 +1211,7 @@ bool GraphicsScene::goToBack()
 	_treeNode = prev;
 
 	_textPath[_treePath.size()] = ANY;
+	updatePending();
 
 	if (_mode != Mode::Test) {
 	    _knot1 = nullptr;
@@ -673,18 +1224,23 @@ bool GraphicsScene::goToBack()
 
 bool GraphicsScene::goToNext(bool ans)
 {
+	TRACE_SPAN("GraphicsScene::goToNext");
+	Recorder::Entry entry(_recorder, Recorder::GoToNext, ans);
+
 	if (!_treeNode || _treePath.size() >= _circles.size() - 2)
 		return false;
+	//Лист раннего выхода уже стоит на последней окружности
+	if (_treeNode->_exit || (_treeNode->_index + 1 >= int(_indexToCircle.size())))
+		return false;
 
 	auto next = _treeNode->_branch[ans];
 	if (!next) {
 		next = std::make_shared<TreeNode>();
 	}
 
-	auto* circle = _treeNode->_circle;
+	syncCenter();
+	auto* circle = circleOf(_treeNode.get());
 	int index = circle->getIndex() + 1;
-	_treeNode->_center =
-	        circle->getCenter();
 	circle->setEnabled(false);
 	circle->setVisible(true);
 
@@ -693,7 +1249,9 @@ bool GraphicsScene::goToNext(bool ans)
 		return false;
 	}
 
-	circle = next->_circle = it->second;
+	//Лист раннего выхода ставит последнюю окружность
+	if (!next->_exit) next->_index = index;
+	circle = circleOf(next.get());
 	circle->setCenter(next->_center);
 	circle->setEnabled(true);
 	circle->setVisible(true);
@@ -701,6 +1259,7 @@ bool GraphicsScene::goToNext(bool ans)
 	_treeNode = next;
 
 	_textPath[index - 2] = '0' + ans;
+	updatePending();
 
 	if (_mode != Mode::Test) {
 		_knot1 = nullptr;
@@ -713,6 +1272,8 @@ bool GraphicsScene::goToNext(bool ans)
 
 bool GraphicsScene::goToInv()
 {
+	Recorder::Entry entry(_recorder, Recorder::GoToInv);
+
 	if (!_treeNode) return false;
 
 	int ans = _textPath[_treePath.size() - 1] == '1';
@@ -725,6 +1286,8 @@ bool GraphicsScene::goToInv()
 
 bool GraphicsScene::goToPath(const std::string &path)
 {
+	Recorder::Entry entry(_recorder, Recorder::GoToPath, QByteArray::fromStdString(path));
+
 	if (!_treeRoot) return false;
 	start();
 	for (char c: path) {
@@ -738,14 +1301,30 @@ bool GraphicsScene::goToPath(const std::string &path)
 
 void GraphicsScene::savePath()
 {
+	Recorder::Entry entry(_recorder, Recorder::SavePath);
+
 	if (_treeNode == nullptr) return;
 
+	//Вклад узлов пути пересчитываем целиком: ветви и флаги меняются
+	const int levels = _indexToCircle.size();
+	const int size = _treePath.size();
+	auto at = [&](int i) { return (i < size)? _treePath[i]: _treeNode; };
+	for (int i = 0, n = attachedCount(); i < n; ++ i) {
+		_stats.add(at(i).get(), i, levels, -1);
+	}
+	auto count = [&]() {
+		for (int i = 0; i <= size; ++ i) _stats.add(at(i).get(), i, levels);
+		updatePending();
+	};
+
 	for (int i = 1; i < _treePath.size(); ++ i) {
 		auto prev = _treePath[i - 1];
 		auto node = _treePath[i];
 		int ans = (_textPath[i - 1] == '1');
 		if (!prev->_branch[ans]) {
 			prev->_branch[ans] = node;
+			prev->_empty[ans] = false;
+			if (_journal) _journal->create(_textPath.substr(0, i), node->_center);
 		}
 	}
 	_treeNode->_fixed = true;
@@ -753,14 +1332,23 @@ void GraphicsScene::savePath()
 		node->_fixed = true;
 	}
 	if (_treePath.empty()) {
+		count();
+		if (_journal) _journal->fix(nodePath());
 		update();
 		return;
 	}
 	auto prev = _treePath.back();
 	int len = _treePath.size();
 	int ans = (_textPath[len - 1] == '1');
+	if (_journal && (prev->_branch[ans] != _treeNode)) {
+		_journal->create(nodePath(), _treeNode->_center);
+	}
 	prev->_branch[ans] =
 	    _treeNode;
+	prev->_empty[ans] = false;
+	count();
+	invalidatePath();
+	if (_journal) _journal->fix(nodePath());
 
 	update();
 }
@@ -775,21 +1363,27 @@ void GraphicsScene::clear()
 	_circle = nullptr;
 	_knot1 = nullptr;
 	_knot2 = nullptr;
+	_stats = TreeStats();
+	++ _revision;
 	updateKnots();
 }
 
 void GraphicsScene::start()
 {
+	Recorder::Entry entry(_recorder, Recorder::Start);
+
 	_textPath = std::string(_circles.size() - 2, ANY);
 
 	if (_mode == Mode::Tree || !_treeRoot) {
 		if (!_treeRoot) {
 			_treeRoot = std::make_shared<TreeNode>();
 			auto circle = _indexToCircle.at(1);
-			_treeRoot->_circle = circle;
 			_treeRoot->_center = circle->getCenter();
+			++ _revision;
+			if (_journal) _journal->create(std::string(), _treeRoot->_center);
+			_stats.add(_treeRoot.get(), 0, _indexToCircle.size());
 		}
-		auto circle = _treeRoot->_circle;
+		auto circle = circleOf(_treeRoot.get());
 		_treeNode = _treeRoot;
 		circle->setCenter(
 		_treeNode->_center
@@ -815,35 +1409,51 @@ void GraphicsScene::start()
 			}
 			c->setEnabled(false);
 		}
-		auto circle = _treeRoot->_circle;
+		auto circle = circleOf(_treeRoot.get());
 		_treeNode = _treeRoot;
 		circle->setCenter(
 		_treeNode->_center
 		);
 		_treePath.clear();
 	}
+	updatePending();
+	_hoverValid = false;
 
 	updateKnots();
 }
 
 void GraphicsScene::reset()
 {
+	Recorder::Entry entry(_recorder, Recorder::Reset);
+
 	if (!_treeNode || (_mode != Mode::Tree)) return;
 
 	if (_treeNode != _treeRoot) {
 		bool ans =
 		_textPath[_treePath.size()-1] == '1';
+		if (_journal) _journal->prune(nodePath());
+		const int levels = _indexToCircle.size();
+		const int depth = _treePath.size();
+		bool attached = isAttached();
+		if (attached) {
+			_stats.addTree(_treeNode.get(), depth, levels, -1);
+			_stats.add(_treePath.back().get(), depth - 1, levels, -1);
+		}
 		goToBack();
 		_treeNode->_branch[ans].reset();
+		if (attached) _stats.add(_treeNode.get(), depth - 1, levels);
+		invalidatePath();
 		goToNext(ans);
 		updateKnots();
 		return;
 	}
 
-	_treeRoot->_circle->setCenter(
+	circleOf(_treeRoot.get())->setCenter(
 	    {0., 0.}
 	);
 	_treeRoot.reset();
+	_stats = TreeStats();
+	if (_journal) _journal->prune(std::string());
 	start();
 }
 
@@ -0,0 +1,108 @@
+#include <heatmap.hpp>
+#include <trace.hpp>
+#include <QtConcurrent>
+#include <QColor>
+
+HeatMap::HeatMap(QObject *parent): QThread(parent) {
+}
+
+HeatMap::~HeatMap()
+{
+	cancel();
+	wait();
+}
+
+void HeatMap::render(std::shared_ptr<const Classifier> classifier,
+                     const QRectF &rect, const QTransform &toModel)
+{
+	QMutexLocker lock(&_mutex);
+	_job = {std::move(classifier), rect, toModel, ++ _generation};
+	_pending = true;
+	_cancel = true;
+	//Работающий поток сам заберет задание после прерывания
+	if (_active) return;
+	_active = true;
+	lock.unlock();
+	//Поток без заданий уже вышел из цикла и только завершается
+	wait();
+	start();
+}
+
+void HeatMap::cancel()
+{
+	QMutexLocker lock(&_mutex);
+	_job = Job();
+	_pending = false;
+	_cancel = true;
+}
+
+QRgb HeatMap::color(const Outcome &outcome)
+{
+	switch (outcome._kind) {
+	case Outcome::Outside:
+		return qRgba(0, 0, 0, 0);
+	case Outcome::Failed:
+		return qRgba(255, 0, 0, 160);
+	case Outcome::Open: {
+		//Незавершенные пути темнее с глубиной
+		int v = std::max(40, 220 - 24 * outcome._depth);
+		return qRgba(v, v, v, 128);
+	}
+	case Outcome::Covered: {
+		//Цвет определяется последней окружностью пути
+		quint64 h = (outcome._path + 1) * 0x9E3779B97F4A7C15ull;
+		return QColor::fromHsv(int(h >> 55) % 360, 160, 255, 128).rgba();
+	}
+	}
+	return 0;
+}
+
+void HeatMap::run()
+{
+	for (;;) {
+		Job job;
+		{
+			QMutexLocker lock(&_mutex);
+			if (!_pending) {
+				_active = false;
+				return;
+			}
+			job = std::move(_job);
+			_job = Job();
+			_pending = false;
+			_cancel = false;
+		}
+		draw(job);
+	}
+}
+
+void HeatMap::draw(const Job &job)
+{
+	TRACE_SPAN("HeatMap::draw");
+	const QRectF &rect = job._rect;
+	const int width = int(rect.width()), height = int(rect.height());
+	if (width <= 0 || height <= 0 || !job._classifier) return;
+
+	QImage image(width, height, QImage::Format_ARGB32);
+	image.fill(Qt::transparent);
+	std::vector<int> rows;
+	for (int step : {8, 4, 2, 1}) {
+		rows.clear();
+		for (int y = 0; y < height; y += step) rows.push_back(y);
+		QtConcurrent::blockingMap(rows, [&](int y) {
+			TRACE_SPAN("HeatMap::row");
+			if (_cancel) return;
+			auto *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+			for (int x = 0; x < width; x += step) {
+				QPointF p(rect.left() + x + step / 2., rect.top() + y + step / 2.);
+				QRgb c = color(job._classifier->classify(job._toModel.map(p)));
+				for (int i = x; i < std::min(x + step, width); ++ i) line[i] = c;
+			}
+			for (int j = y + 1; j < std::min(y + step, height); ++ j) {
+				std::copy(line, line + width, reinterpret_cast<QRgb*>(image.scanLine(j)));
+			}
+		});
+		if (_cancel) return;
+		emit imageReady(image.copy(), job._generation);
+	}
+}
@@ -0,0 +1,208 @@
+#include <journal.hpp>
+#include <QSaveFile>
+#include <algorithm>
+
+namespace {
+
+struct Record {
+	bool read(QDataStream &stream)
+	{
+		stream >> op >> path;
+		if ((op == Journal::Create) || (op == Journal::Center)) {
+			stream >> center;
+		}
+		return (stream.status() == QDataStream::Ok) && (op <= Journal::Prune);
+	}
+
+	quint8 op = 0;
+	QByteArray path;
+	QPointF center;
+};
+
+}
+
+Journal::Journal(QObject *parent): QObject(parent) {
+}
+
+Journal::~Journal()
+{
+	close();
+}
+
+bool Journal::open(const QString &treeFile)
+{
+	close();
+	_file.setFileName(fileName(treeFile));
+	if (!_file.open(QIODevice::ReadWrite)) return false;
+	_stream.setDevice(&_file);
+	_stream.setVersion(QDataStream::Qt_5_0);
+
+	//Журнал с чужим заголовком начинаем заново
+	quint32 magic = 0;
+	quint16 version = 0;
+	_stream >> magic >> version;
+	if ((magic != MAGIC) || (version != VERSION)) {
+		_file.resize(0);
+		_file.seek(0);
+		_stream.resetStatus();
+		_stream << MAGIC << VERSION;
+	}
+	else {
+		//Обрезаем запись, прерванную аварийным завершением
+		qint64 end = _file.pos();
+		Record record;
+		while (!_stream.atEnd() && record.read(_stream)) {
+			end = _file.pos();
+		}
+		_stream.resetStatus();
+		_file.resize(end);
+	}
+	_file.seek(_file.size());
+	_treeFile = treeFile;
+	_requested = false;
+	return true;
+}
+
+void Journal::close()
+{
+	if (!_file.isOpen()) return;
+	_stream.setDevice(nullptr);
+	_file.close();
+	_treeFile.clear();
+}
+
+void Journal::requestCompaction()
+{
+	if (!_file.isOpen() || _requested) return;
+	_requested = true;
+	emit compactionNeeded();
+}
+
+qint64 Journal::mark()
+{
+	if (!_file.isOpen()) return HEADER;
+	_file.flush();
+	return _file.size();
+}
+
+bool Journal::compact(qint64 mark, const QString &target)
+{
+	if (!_file.isOpen()) return false;
+	_file.flush();
+	_requested = false;
+	mark = std::max(mark, HEADER);
+
+	//Записи после отметки переносим в новый журнал
+	_file.seek(mark);
+	QByteArray tail = _file.readAll();
+	QString treeFile = target.isEmpty()? _treeFile: target;
+	close();
+	{
+		QSaveFile file(fileName(treeFile));
+		if (!file.open(QIODevice::WriteOnly)) return false;
+		QDataStream stream(&file);
+		stream.setVersion(QDataStream::Qt_5_0);
+		stream << MAGIC << VERSION;
+		stream.writeRawData(tail.constData(), tail.size());
+		if (!file.commit()) return false;
+	}
+	return open(treeFile);
+}
+
+//Узел по пути ответов. Возвращает false, если путь уходит ниже листа:
+//журнал тогда не соответствует дереву
+static bool node(TreeDocument &doc, const QByteArray &path, bool create,
+                 std::shared_ptr<TreeNode> &result)
+{
+	result.reset();
+	const int last = int(doc._radius.size()) - 1;
+	if (path.size() + 1 > last) return false;
+	if (!doc._root && create) {
+		doc._root = std::make_shared<TreeNode>();
+	}
+	auto current = doc._root;
+	for (char c : path) {
+		if (!current) break;
+		if (current->_exit || (current->_index >= last)) return false;
+		int ans = c == '1';
+		auto &next = current->_branch[ans];
+		if (!next && create) {
+			next = std::make_shared<TreeNode>();
+			next->_index = current->_index + 1;
+			current->_empty[ans] = false;
+		}
+		current = next;
+	}
+	result = current;
+	return true;
+}
+
+//Смещенный узел меняет ячейки потомков, их пустые ветви не подтверждены
+static void clearEmpty(TreeNode *node)
+{
+	node->_empty = {false, false};
+	for (auto &next : node->_branch) {
+		if (next) clearEmpty(next.get());
+	}
+}
+
+qint64 Journal::replay(const QString &treeFile, TreeDocument &doc, QString *error)
+{
+	QFile file(fileName(treeFile));
+	if (!file.exists()) return 0;
+	if (!file.open(QIODevice::ReadOnly)) {
+		if (error) *error = file.errorString();
+		return -1;
+	}
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	quint32 magic;
+	quint16 version;
+	stream >> magic >> version;
+	if ((magic != MAGIC) || (version != VERSION)) return 0;
+
+	qint64 count = 0;
+	Record record;
+	//Незаконченная последняя запись отбрасывается, как и все записи
+	//начиная с первой, не подходящей к дереву
+	while (!stream.atEnd() && record.read(stream)) {
+		const auto &path = record.path;
+		const auto &center = record.center;
+		auto op = record.op;
+
+		std::shared_ptr<TreeNode> current;
+		if (op == Create) {
+			if (!node(doc, path, true, current)) break;
+			if (current) current->_center = center;
+		}
+		else
+		if (op == Center) {
+			if (!node(doc, path, false, current)) break;
+			if (current) {
+				current->_center = center;
+				clearEmpty(current.get());
+			}
+		}
+		else
+		if (op == Fix) {
+			current = doc._root;
+			for (int i = 0; current; ++ i) {
+				current->_fixed = true;
+				if (i == path.size()) break;
+				current = current->_branch[path[i] == '1'];
+			}
+		}
+		else
+		if (op == Prune) {
+			if (path.isEmpty()) {
+				doc._root.reset();
+			}
+			else {
+				if (!node(doc, path.left(path.size() - 1), false, current)) break;
+				if (current) current->_branch[path.at(path.size() - 1) == '1'].reset();
+			}
+		}
+		++ count;
+	}
+	return count;
+}
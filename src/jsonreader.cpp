@@ -0,0 +1,143 @@
+#include <jsonreader.hpp>
+#include <QString>
+
+JsonReader::JsonReader(QIODevice *device): _device(device)
+{
+	_size = device->size();
+}
+
+bool JsonReader::fill()
+{
+	if (_offset < _buffer.size()) return true;
+	_buffer = _device->read(_chunk);
+	_offset = 0;
+	return !_buffer.isEmpty();
+}
+
+int JsonReader::get()
+{
+	if (!fill()) return -1;
+	++ _pos;
+	return (unsigned char) _buffer[_offset++];
+}
+
+int JsonReader::look()
+{
+	if (!fill()) return -1;
+	return (unsigned char) _buffer[_offset];
+}
+
+JsonReader::Token JsonReader::next()
+{
+	if (_peeked) {
+		_peeked = false;
+		return _ahead;
+	}
+	return read();
+}
+
+JsonReader::Token JsonReader::peek()
+{
+	if (!_peeked) {
+		_ahead = read();
+		_peeked = true;
+	}
+	return _ahead;
+}
+
+bool JsonReader::skip(Token token)
+{
+	int level = 0;
+	for (;;) {
+		switch (token) {
+		case BeginObject:
+		case BeginArray:
+			++ level;
+			break;
+		case EndObject:
+		case EndArray:
+			-- level;
+			break;
+		case End:
+		case Invalid:
+			return false;
+		default:
+			break;
+		}
+		if (level <= 0) return !level;
+		token = next();
+	}
+}
+
+JsonReader::Token JsonReader::read()
+{
+	_text.clear();
+
+	//Разделители не несут информации для разбора дерева
+	int c;
+	do {
+		c = get();
+	}
+	while (c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+	       c == ',' || c == ':');
+
+	switch (c) {
+	case -1: return End;
+	case '{': return BeginObject;
+	case '}': return EndObject;
+	case '[': return BeginArray;
+	case ']': return EndArray;
+	case '"':
+		for (;;) {
+			c = get();
+			if (c < 0) return Invalid;
+			if (c == '"') return String;
+			if (c != '\\') {
+				_text.append(char(c));
+				continue;
+			}
+			c = get();
+			switch (c) {
+			case 'b': _text.append('\b'); break;
+			case 'f': _text.append('\f'); break;
+			case 'n': _text.append('\n'); break;
+			case 'r': _text.append('\r'); break;
+			case 't': _text.append('\t'); break;
+			case 'u': {
+				QByteArray hex;
+				for (int i = 0; i < 4; ++ i) hex.append(char(get()));
+				bool ok;
+				ushort code = hex.toUShort(&ok, 16);
+				if (!ok) return Invalid;
+				_text.append(QString(QChar(code)).toUtf8());
+				break;
+			}
+			case -1: return Invalid;
+			default: _text.append(char(c));
+			}
+		}
+	default:
+		break;
+	}
+
+	if (c == '-' || (c >= '0' && c <= '9')) {
+		_text.append(char(c));
+		while (((c = look()) >= '0' && c <= '9') ||
+		       c == '-' || c == '+' || c == '.' ||
+		       c == 'e' || c == 'E') {
+			_text.append(char(get()));
+		}
+		bool ok;
+		_text.toDouble(&ok);
+		return ok? Number: Invalid;
+	}
+	if (c >= 'a' && c <= 'z') {
+		_text.append(char(c));
+		while ((c = look()) >= 'a' && c <= 'z') {
+			_text.append(char(get()));
+		}
+		if (_text == "true" || _text == "false") return Bool;
+		if (_text == "null") return Null;
+	}
+	return Invalid;
+}
@@ -1,10 +1,26 @@
 #include <mainwindow.hpp>
+#include <console.hpp>
+#include <trace.hpp>
 #include <QApplication>
 
 int main(int argc, char *argv[]) {
 
-	QApplication app(argc, argv);
-	MainWindow win;
-	win.show();
-	return app.exec();
+	//Интервалы всего запуска выгружаются в файл из CIRCLEGEN_TRACE
+	QString trace = QString::fromLocal8Bit(qgetenv("CIRCLEGEN_TRACE"));
+	Trace::enable(!trace.isEmpty());
+	int result;
+	if (Console::accepts(argc, argv)) {
+		result = Console::exec(argc, argv);
+	}
+	else {
+		QApplication app(argc, argv);
+		MainWindow win;
+		win.show();
+		result = app.exec();
+	}
+	if (!trace.isEmpty()) {
+		Trace::enable(false);
+		Trace::dump(trace);
+	}
+	return result;
 }
@@ -2,10 +2,19 @@
 #include <mainwindow.hpp>
 
 #include <graphicsscene.hpp>
+#include <treetask.hpp>
+#include <recorder.hpp>
+#include <monitorchannel.hpp>
+#include <journal.hpp>
+#include <thumbnails.hpp>
+#include <trace.hpp>
 #include <QInputDialog>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QProgressDialog>
 #include <QColor>
+#include <QDateTime>
+#include <QTextStream>
 #include <iostream>
 #include <set>
 
@@ -13,13 +22,45 @@ using Mode = GraphicsScene::Mode;
 
 MainWindow::MainWindow(QWidget *parent): QMainWindow(parent), ui(new Ui::MainWindow) {
 	ui->setupUi(this);
-	ui->graphicsView->getScene()->setMonitor(this);
+	channel = new MonitorChannel(this, this);
+	ui->graphicsView->getScene()->setMonitor(channel);
+	ui->treeMap->setScene(ui->graphicsView->getScene());
+	connect(ui->treeMap, &TreeMap::pathClicked, this, [this](const QString &path) {
+		ui->graphicsView->getScene()->goToPath(path.toStdString());
+	});
 
-	this->listModel = new QStringListModel(this);
+	journal = new Journal(this);
+	ui->graphicsView->getScene()->setJournal(journal);
+	connect(journal, &Journal::compactionNeeded, this, &MainWindow::compactJournal);
+
+	//Бюджет миниатюр в мегабайтах задается переменной окружения
+	qint64 budget = 16;
+	if (qEnvironmentVariableIsSet("CIRCLEGEN_THUMBNAILS_MB")) {
+		budget = qEnvironmentVariableIntValue("CIRCLEGEN_THUMBNAILS_MB");
+	}
+	auto *scene = ui->graphicsView->getScene();
+	thumbnails = new Thumbnails([scene]() {
+		return scene->snapshot();
+	}, [scene]() {
+		return scene->getRevision();
+	}, budget << 20, this);
+	connect(thumbnails, &Thumbnails::ready, this, &MainWindow::updateNavigation);
+	connect(thumbnails, &Thumbnails::changed, this, &MainWindow::updateNavigation);
+	for (auto *button : {ui->buttonFalse, ui->buttonTrue}) {
+		button->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);
+		button->setIconSize(QSize(Thumbnails::SIZE / 2, Thumbnails::SIZE / 2));
+	}
+
+	this->listModel = new ThumbnailModel(thumbnails, this);
 	ui->listView->setModel(listModel);
+	ui->listView->setIconSize(QSize(Thumbnails::SIZE / 2, Thumbnails::SIZE / 2));
+	ui->buttonTrace->setChecked(Trace::isEnabled());
 }
 
 MainWindow::~MainWindow() {
+	ui->graphicsView->getScene()->setJournal(nullptr);
+	ui->graphicsView->getScene()->setRecorder(nullptr);
+	delete recorder;
 	delete ui;
 }
 
@@ -40,7 +81,43 @@ void MainWindow::sendTreePath(const QString &path, bool fixed)
 	QPalette palette;
 	palette.setColor(QPalette::WindowText, fixed? Qt::black: Qt::red);
 	ui->labelTreePath->setPalette(palette);
+	ui->treeMap->update();
+	//Путь отправляется каждый кадр, кнопки меняются только вместе с ним
+	if (path == ui->labelTreePath->text()) return;
 	ui->labelTreePath->setText(path);
+	updateNavigation();
+}
+
+void MainWindow::updateNavigation()
+{
+	//Кнопки перехода показывают состояния следующих узлов
+	std::string path = ui->labelTreePath->text().toStdString();
+	auto depth = path.find(GraphicsScene::ANY);
+	const std::pair<QToolButton*, char> buttons[] = {
+	    {ui->buttonFalse, '0'}, {ui->buttonTrue, '1'}
+	};
+	for (const auto &[button, ans] : buttons) {
+		QImage image;
+		if (depth != std::string::npos) {
+			image = thumbnails->find(path.substr(0, depth) + ans);
+		}
+		button->setIcon(image.isNull()? QIcon(): QIcon(QPixmap::fromImage(image)));
+		button->setToolTip(image.isNull()? QString(): Thumbnails::toolTip(image));
+	}
+}
+
+void MainWindow::sendStats(const TreeStats &stats)
+{
+	ui->labelStats->setText(stats.toText());
+}
+
+void MainWindow::sendSplit(qreal inside, qreal outside, bool covered)
+{
+	ui->labelSplit->setText(
+	    "inside: " + QString::number(inside, 'g', 4) +
+	    ", outside: " + QString::number(outside, 'g', 4) +
+	    (covered? ", covered": "")
+	);
 }
 
 void MainWindow::sendError(const QString &message)
@@ -57,6 +134,7 @@ void MainWindow::on_buttonPrint_clicked()
 {
 	auto *view = ui->graphicsView;
 
+	auto *scene = view->getScene();
 	auto print = [&](const QString &fname) {
 		QImage image(view->width(), view->height(), QImage::Format_ARGB32);
 		image.fill(Qt::white);
@@ -75,23 +153,24 @@ void MainWindow::on_buttonPrint_clicked()
 		return text;
 	};
 
+	scene->flush();
 	if (!ui->checkAllBranches->isChecked()) {
 		print("print.png");
 		return;
 	}
 
-	auto *scene = view->getScene();
 	if (scene->getMode() != GraphicsScene::Mode::Tree) {
 		return;
 	}
 	scene->setVisibleKnots(false);
 	scene->start();
+	scene->flush();
 	view->setEnabled(false);
 	std::vector<int> path;
 	int index = 0;
 	if (scene->isFixedPath()) {
 		print(
-		name(ui->labelTreePath->text(), index++)
+		name(QString::fromStdString(scene->getTextPath()), index++)
 		);
 		path.push_back(0);
 	}
@@ -109,8 +188,9 @@ void MainWindow::on_buttonPrint_clicked()
 			scene->goToBack();
 			continue;
 		}
+		scene->flush();
 		print(
-		name(ui->labelTreePath->text(), index++)
+		name(QString::fromStdString(scene->getTextPath()), index++)
 		);
 		path.push_back(0);
 	}
@@ -122,20 +202,233 @@ void MainWindow::on_buttonSave_clicked()
 {
 	QString fileName = QFileDialog::getSaveFileName(this);
 	if (fileName.isEmpty()) return;
-	QFile file(fileName);
-	file.open(QIODevice::WriteOnly | QIODevice::Text);
-	ui->graphicsView->getScene()->saveToFile(&file);
+	auto *task = new TreeTask(TreeTask::Save, fileName, this);
+	auto *scene = ui->graphicsView->getScene();
+	scene->flush();
+	task->setDocument(scene->getDocument());
+	task->setJournalMark(journal->mark());
+	task->setRevision(scene->getRevision());
+	task->setIndexing(true);
+	runTask(task, "Saving tree...");
 }
 
 void MainWindow::on_buttonOpen_clicked()
 {
 	QString fileName = QFileDialog::getOpenFileName(this);
 	if (fileName.isEmpty()) return;
+	auto *task = new TreeTask(TreeTask::Load, fileName, this);
+	runTask(task, "Loading tree...");
+}
+
+void MainWindow::on_buttonDiff_clicked()
+{
+	QString base = currentFile;
+	if (base.isEmpty()) {
+		base = QFileDialog::getOpenFileName(this, "Base tree");
+		if (base.isEmpty()) return;
+	}
+	QString other = QFileDialog::getOpenFileName(this, "Compare with");
+	if (other.isEmpty()) return;
+	auto *task = new TreeTask(TreeTask::Diff, base, this);
+	task->setOther(other);
+	runTask(task, "Comparing trees...");
+}
+
+void MainWindow::on_buttonExport_clicked()
+{
+	QString fileName = QFileDialog::getSaveFileName(
+	    this, "Export C++ header", QString(), "C++ headers (*.hpp *.h)"
+	);
+	if (fileName.isEmpty()) return;
+	auto *task = new TreeTask(TreeTask::Export, fileName, this);
+	auto *scene = ui->graphicsView->getScene();
+	scene->flush();
+	task->setDocument(scene->getDocument());
+	runTask(task, "Exporting tree...");
+}
+
+void MainWindow::on_buttonPoster_clicked()
+{
+	auto *scene = ui->graphicsView->getScene();
+	bool ok;
+	int width = QInputDialog::getInt(
+	    this, "Poster", "Width, px:", 8 * int(scene->sceneRect().width()),
+	    Poster::TILE, 65536, 1, &ok
+	);
+	if (!ok) return;
+	QString fileName = QFileDialog::getSaveFileName(
+	    this, "Export poster", QString(), "TIFF images (*.tif *.tiff)"
+	);
+	if (fileName.isEmpty()) return;
+
+	//Снимок сцены берется сейчас, плитки строятся в фоне
+	scene->flush();
+	auto *task = new TreeTask(TreeTask::Image, fileName, this);
+	task->setPoster(std::make_shared<Poster>(scene, width));
+	runTask(task, "Exporting poster...");
+}
+
+void MainWindow::on_buttonStats_clicked()
+{
+	QString fileName = QFileDialog::getSaveFileName(
+	    this, "Append statistics", QString(), "CSV (*.csv)",
+	    nullptr, QFileDialog::DontConfirmOverwrite
+	);
+	if (fileName.isEmpty()) return;
+
+	//Каждый снимок дописывается строкой с отметкой времени
 	QFile file(fileName);
-	file.open(QIODevice::ReadOnly | QIODevice::Text);
-	ui->graphicsView->getScene()->loadFromFile(&file);
+	bool header = !file.exists() || !file.size();
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+		sendError(file.errorString());
+		return;
+	}
+	QTextStream out(&file);
+	if (header) {
+		out << "time,file," << TreeStats::csvHeader() << "\n";
+	}
+	out << QDateTime::currentDateTime().toString(Qt::ISODate) << ','
+	    << QFileInfo(currentFile).fileName() << ','
+	    << ui->graphicsView->getScene()->getStats().toCsv() << "\n";
+}
 
-	listModel->removeRows(0, listModel->rowCount());
+void MainWindow::on_buttonRecord_clicked()
+{
+	auto *scene = ui->graphicsView->getScene();
+	if (recorder) {
+		scene->setRecorder(nullptr);
+		delete recorder;
+		recorder = nullptr;
+		ui->buttonRecord->setChecked(false);
+		return;
+	}
+	ui->buttonRecord->setChecked(false);
+	QString fileName = QFileDialog::getSaveFileName(this, "Record session");
+	if (fileName.isEmpty()) return;
+	scene->flush();
+	recorder = new Recorder();
+	if (!recorder->open(fileName, scene)) {
+		delete recorder;
+		recorder = nullptr;
+		sendError("Can't open file!");
+		return;
+	}
+	scene->setRecorder(recorder);
+	ui->buttonRecord->setChecked(true);
+}
+
+void MainWindow::on_buttonTrace_clicked()
+{
+	//Первое нажатие начинает запись, второе выгружает интервалы
+	if (!Trace::isEnabled()) {
+		Trace::clear();
+		Trace::enable(true);
+		ui->buttonTrace->setChecked(true);
+		return;
+	}
+	Trace::enable(false);
+	ui->buttonTrace->setChecked(false);
+	QString fileName = QFileDialog::getSaveFileName(this, "Save trace", "", "Trace (*.json)");
+	if (fileName.isEmpty()) return;
+	if (!Trace::dump(fileName)) {
+		sendError("Can't save file!");
+	}
+}
+
+void MainWindow::runTask(TreeTask *task, const QString &label)
+{
+	auto *dialog = new QProgressDialog(label, "Cancel", 0, 100, this);
+	dialog->setWindowModality(Qt::WindowModal);
+	dialog->setMinimumDuration(500);
+	dialog->setAutoClose(false);
+	dialog->setAutoReset(false);
+	dialog->setValue(0);
+
+	connect(task, &TreeTask::progressChanged, dialog, &QProgressDialog::setValue);
+	connect(dialog, &QProgressDialog::canceled, task, &TreeTask::requestInterruption);
+	connect(task, &TreeTask::finished, this, [this, task, dialog]() {
+		dialog->deleteLater();
+		task->deleteLater();
+		if (!task->isSucceeded()) {
+			if (!task->isCanceled()) {
+				sendError(task->getError());
+			}
+			return;
+		}
+		if (task->getKind() == TreeTask::Diff) {
+			QStringList list;
+			std::map<std::string, char> marks;
+			for (const auto &change : task->getChanges()) {
+				char symbol = TreeDiff::symbol(change._kind);
+				list.append(QString(QChar(symbol)) + " " + change._path.c_str());
+				marks[change._path] = symbol;
+			}
+			listModel->setStringList(list);
+			ui->treeMap->setMarks(std::move(marks));
+			return;
+		}
+		if ((task->getKind() == TreeTask::Export) || (task->getKind() == TreeTask::Image)) {
+			ui->statusBar->showMessage("Exported: " + task->getFileName());
+			return;
+		}
+		currentFile = task->getFileName();
+		auto *scene = ui->graphicsView->getScene();
+		if (task->getKind() == TreeTask::Load) {
+			//Подменяем дерево целиком, когда оно полностью прочитано.
+			//Загрузка пишется до подмены, как и остальные операции
+			Recorder::Entry entry(recorder, Recorder::Load, task->getFileName());
+			journal->close();
+			scene->setDocument(
+			    task->takeDocument()
+			);
+			scene->setQuadTree(task->takeQuadTree(), scene->getRevision());
+			journal->open(currentFile);
+			if (task->getRecovered() > 0) {
+				ui->statusBar->showMessage(
+				    "Recovered edits: " + QString::number(task->getRecovered())
+				);
+				compactJournal();
+			}
+			listModel->removeRows(0, listModel->rowCount());
+			ui->treeMap->setMarks({});
+		}
+		else {
+			scene->setQuadTree(task->takeQuadTree(), task->getRevision());
+			//Правки, сделанные после снимка, в файл не попали: они
+			//остаются в журнале сохраненного файла
+			if (!journal->compact(task->getJournalMark(), currentFile)) {
+				//Журнала не было: прежние записи рядом с файлом устарели
+				journal->open(currentFile);
+				journal->compact(journal->mark());
+			}
+		}
+	});
+	task->start();
+}
+
+void MainWindow::compactJournal()
+{
+	if (compacting || !journal->isOpen()) return;
+
+	//Записи, сделанные во время сохранения, остаются в журнале
+	auto *scene = ui->graphicsView->getScene();
+	scene->flush();
+	auto *task = new TreeTask(TreeTask::Save, journal->getTreeFile(), this);
+	task->setDocument(scene->getDocument());
+	qint64 mark = journal->mark();
+	compacting = true;
+	connect(task, &TreeTask::finished, this, [this, task, mark]() {
+		task->deleteLater();
+		compacting = false;
+		if (!task->isSucceeded()) {
+			ui->statusBar->showMessage("Autosave failed: " + task->getError());
+			return;
+		}
+		if (task->getFileName() == journal->getTreeFile()) {
+			journal->compact(mark);
+		}
+	});
+	task->start();
 }
 
 void MainWindow::on_buttonPlace_clicked()
@@ -181,23 +474,62 @@ void MainWindow::on_buttonPlace_clicked()
 
 void MainWindow::on_buttonCheck_clicked()
 {
+	auto *scene = ui->graphicsView->getScene();
 	std::vector<std::string> result;
-	ui->graphicsView->getScene()->check(result);
+	scene->flush();
+	scene->check(result);
 	QStringList list;
 	for (const auto& r: result) {
 		list.append(r.c_str());
 	}
+	qreal uncovered = 0.;
+	auto status = scene->verify(&uncovered);
+
+	//Самые неустойчивые листья идут следом за открытыми путями
+	qreal margin = scene->measure();
+	scene->weakest(result, 10);
+	for (const auto& r: result) {
+		list.append(r.c_str());
+	}
 	listModel->setStringList(
 	    list
 	);
+	const char *text[] = {"Unknown", "Solved", "Open", "Failed"};
+	ui->statusBar->showMessage(
+	    QString(text[status]) + ", uncovered area: " +
+	    QString::number(uncovered) + ", margin: " +
+	    QString::number(margin)
+	);
+}
+
+void MainWindow::on_buttonSimplify_clicked()
+{
+	auto removed = ui->graphicsView->getScene()->simplify();
+	on_buttonCheck_clicked();
+	ui->statusBar->showMessage(
+	    ui->statusBar->currentMessage() + ", removed nodes: " +
+	    QString::number(removed)
+	);
+}
+
+void MainWindow::on_buttonExits_clicked()
+{
+	qreal before = 0., after = 0.;
+	auto exits = ui->graphicsView->getScene()->earlyExit(&before, &after);
+	on_buttonCheck_clicked();
+	ui->statusBar->showMessage(
+	    ui->statusBar->currentMessage() + ", early exits: " +
+	    QString::number(exits) + ", expected depth: " +
+	    QString::number(before) + " -> " + QString::number(after)
+	);
 }
 
 void MainWindow::on_listView_clicked()
 {
 	QModelIndex index = ui->listView->currentIndex();
 	QString text = index.data(Qt::DisplayRole).toString();
-	auto path = text.toStdString();
-	ui->graphicsView->getScene()->goToPath(path);
+
+	ui->graphicsView->getScene()->goToPath(ThumbnailModel::pathOf(text));
 }
 
 void MainWindow::on_buttonReset_clicked()
@@ -299,3 +631,24 @@ void MainWindow::on_checkFill_clicked()
 	ui->checkFill->isChecked()
 	);
 }
+
+void MainWindow::on_checkHover_clicked()
+{
+	ui->graphicsView->getScene()->setHover(
+	ui->checkHover->isChecked()
+	);
+}
+
+void MainWindow::on_checkBatch_clicked()
+{
+	ui->graphicsView->getScene()->setBatchRendering(
+	ui->checkBatch->isChecked()
+	);
+}
+
+void MainWindow::on_checkHeat_clicked()
+{
+	ui->graphicsView->getScene()->setHeatMap(
+	ui->checkHeat->isChecked()
+	);
+}
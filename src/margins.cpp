@@ -0,0 +1,85 @@
+#include <margins.hpp>
+#include <trace.hpp>
+#include <QtConcurrent>
+#include <algorithm>
+
+static bool cached(const TreeNode *node)
+{
+	return !std::isnan(node->_margin);
+}
+
+qreal Margins::measure(TreeNode *root) const
+{
+	if (!root) return std::numeric_limits<qreal>::infinity();
+
+	//Поддеревья на глубине SPLIT считаются независимо
+	std::vector<Task> tasks;
+	Cell cell(_base);
+	collect(root, cell, 0, tasks);
+	QtConcurrent::blockingMap(tasks, [this](Task &task) {
+		TRACE_SPAN("Margins::measure");
+		measure(task._node, task._cell);
+	});
+	return combine(root);
+}
+
+void Margins::collect(TreeNode *node, Cell &cell, int depth, std::vector<Task> &tasks) const
+{
+	if (cached(node)) return;
+	if ((depth >= SPLIT) || (node->_index + 1 >= int(_radius.size()))) {
+		tasks.push_back({node, cell});
+		return;
+	}
+	Disk disk{node->_center, _radius.at(node->_index)};
+	for (int i = 0; i < 2; ++ i) {
+		auto *next = node->_branch[i].get();
+		if (!next) continue;
+		cell.push(disk, i);
+		collect(next, cell, depth + 1, tasks);
+		cell.pop();
+	}
+}
+
+qreal Margins::measure(TreeNode *node, Cell &cell) const
+{
+	if (cached(node)) return node->_margin;
+
+	Disk disk{node->_center, _radius.at(node->_index)};
+	if (node->_index + 1 >= int(_radius.size())) {
+		//Дальняя точка ячейки оценивается по сетке с поправкой на ее шаг
+		const int resolution = Cell::RESOLUTION;
+		auto points = cell.samples(resolution);
+		qreal outer = 0.;
+		for (const auto &p : points) {
+			QPointF d = p - disk._center;
+			outer = std::max(outer, QPointF::dotProduct(d, d));
+		}
+		const QRectF &rect = cell.bounds();
+		qreal step = std::hypot(rect.width(), rect.height()) / (2 * resolution);
+		node->_margin = points.empty()?
+		                std::numeric_limits<qreal>::infinity():
+		                disk._radius - std::sqrt(outer) - step;
+		return node->_margin;
+	}
+	qreal margin = std::numeric_limits<qreal>::infinity();
+	for (int i = 0; i < 2; ++ i) {
+		auto *next = node->_branch[i].get();
+		if (!next) continue;
+		cell.push(disk, i);
+		margin = std::min(margin, measure(next, cell));
+		cell.pop();
+	}
+	node->_margin = margin;
+	return margin;
+}
+
+qreal Margins::combine(TreeNode *node)
+{
+	if (cached(node)) return node->_margin;
+	qreal margin = std::numeric_limits<qreal>::infinity();
+	for (auto &next : node->_branch) {
+		if (next) margin = std::min(margin, combine(next.get()));
+	}
+	node->_margin = margin;
+	return margin;
+}
@@ -0,0 +1,89 @@
+#include <monitorchannel.hpp>
+#include <QMutexLocker>
+
+MonitorChannel::MonitorChannel(Monitor *target, QObject *parent):
+    QObject(parent), _target(target) {
+}
+
+MonitorChannel::~MonitorChannel()
+{
+}
+
+void MonitorChannel::sendPosition(const QPointF &point, bool fixed)
+{
+	QMutexLocker lock(&_mutex);
+	(fixed? _pending._fixedPosition: _pending._position) = point;
+	post(fixed? FixedPosition: Position);
+}
+
+void MonitorChannel::sendTreePath(const QString &path, bool fixed)
+{
+	QMutexLocker lock(&_mutex);
+	_pending._path = path;
+	_pending._fixedPath = fixed;
+	post(TreePath);
+}
+
+void MonitorChannel::sendStats(const TreeStats &stats)
+{
+	QMutexLocker lock(&_mutex);
+	_pending._stats = stats;
+	post(Stats);
+}
+
+void MonitorChannel::sendSplit(qreal inside, qreal outside, bool covered)
+{
+	QMutexLocker lock(&_mutex);
+	_pending._inside = inside;
+	_pending._outside = outside;
+	_pending._covered = covered;
+	post(Split);
+}
+
+void MonitorChannel::sendError(const QString &message)
+{
+	QMutexLocker lock(&_mutex);
+	//Одинаковые сообщения подряд показываем один раз
+	if (_pending._errors.isEmpty() || _pending._errors.back() != message) {
+		_pending._errors.push_back(message);
+	}
+	post(0);
+}
+
+void MonitorChannel::post(int kind)
+{
+	_pending._kinds |= kind;
+	if (_posted) return;
+	_posted = true;
+	QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection);
+}
+
+void MonitorChannel::deliver()
+{
+	Pending pending;
+	{
+		QMutexLocker lock(&_mutex);
+		std::swap(pending, _pending);
+		_posted = false;
+	}
+	if (!_target) return;
+	if (pending._kinds & Position) {
+		_target->sendPosition(pending._position, false);
+	}
+	if (pending._kinds & FixedPosition) {
+		_target->sendPosition(pending._fixedPosition, true);
+	}
+	if (pending._kinds & TreePath) {
+		_target->sendTreePath(pending._path, pending._fixedPath);
+	}
+	if (pending._kinds & Stats) {
+		_target->sendStats(pending._stats);
+	}
+	if (pending._kinds & Split) {
+		_target->sendSplit(pending._inside, pending._outside, pending._covered);
+	}
+	//Ошибки доставляем последними: окно сообщения запускает свой цикл событий
+	for (const auto &message : pending._errors) {
+		_target->sendError(message);
+	}
+}
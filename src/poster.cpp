@@ -0,0 +1,163 @@
+#include <poster.hpp>
+#include <trace.hpp>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsLineItem>
+#include <QtConcurrent>
+#include <QPainter>
+#include <cmath>
+
+namespace {
+
+//Поля TIFF пишутся в порядке младших байтов
+void put16(QByteArray &data, quint16 value)
+{
+	data += char(value & 0xFF);
+	data += char(value >> 8);
+}
+
+void put32(QByteArray &data, quint32 value)
+{
+	put16(data, value & 0xFFFF);
+	put16(data, value >> 16);
+}
+
+enum Type: quint16 { SHORT = 3, LONG = 4 };
+
+}
+
+Poster::Poster(QGraphicsScene *scene, int width):
+    _rect(scene->sceneRect()), _width(width)
+{
+	_height = std::max(1, int(std::lround(width * _rect.height() / _rect.width())));
+	for (auto *item : scene->items(Qt::AscendingOrder)) {
+		if (!item->isVisible()) continue;
+		if (auto *ellipse = qgraphicsitem_cast<QGraphicsEllipseItem*>(item)) {
+			_shapes.push_back({false, item->sceneTransform().mapRect(ellipse->rect()),
+			                   QLineF(), ellipse->pen(), ellipse->brush()});
+		}
+		else
+		if (auto *line = qgraphicsitem_cast<QGraphicsLineItem*>(item)) {
+			_shapes.push_back({true, QRectF(), item->sceneTransform().map(line->line()),
+			                   line->pen(), Qt::NoBrush});
+		}
+	}
+}
+
+QImage Poster::renderTile(int column, int row) const
+{
+	TRACE_SPAN("Poster::renderTile");
+	QImage image(TILE, TILE, QImage::Format_RGB32);
+	image.fill(Qt::white);
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing);
+
+	//Плитка - окно в изображении, растянутом из прямоугольника сцены
+	qreal scale = _width / _rect.width();
+	painter.translate(-column * TILE, -row * TILE);
+	painter.scale(scale, scale);
+	painter.translate(-_rect.topLeft());
+	QRectF visible = painter.transform().inverted().mapRect(QRectF(0, 0, TILE, TILE));
+	for (const auto &shape : _shapes) {
+		painter.setPen(shape._pen);
+		qreal margin = shape._pen.widthF();
+		if (shape._line) {
+			QRectF bounds = QRectF(shape._segment.p1(), shape._segment.p2()).normalized();
+			if (!bounds.adjusted(-margin, -margin, margin, margin).intersects(visible)) continue;
+			painter.drawLine(shape._segment);
+		}
+		else {
+			if (!shape._rect.adjusted(-margin, -margin, margin, margin).intersects(visible)) continue;
+			painter.setBrush(shape._brush);
+			painter.drawEllipse(shape._rect);
+		}
+	}
+	return image;
+}
+
+bool Poster::write(QIODevice *device, const TreeFile::Progress &progress, QString *error) const
+{
+	auto fail = [error](const QString &message) {
+		if (error) *error = message;
+		return false;
+	};
+	const quint32 across = (_width + TILE - 1) / TILE;
+	const quint32 down = (_height + TILE - 1) / TILE;
+	const quint32 count = across * down;
+	const quint64 tileBytes = quint64(TILE) * TILE * 3;
+
+	//Заголовок, каталог и массивы смещений лежат перед плитками
+	const quint16 entries = 11;
+	const quint32 bits = 8 + 2 + 12 * entries + 4;
+	const quint32 offsets = bits + 8;
+	const quint32 counts = offsets + 4 * count;
+	const quint64 data = counts + 4 * count;
+	if (data + count * tileBytes > std::numeric_limits<quint32>::max()) {
+		return fail("Image is too large for TIFF!");
+	}
+
+	QByteArray header("II");
+	put16(header, 42);
+	put32(header, 8);
+	put16(header, entries);
+	auto entry = [&header](quint16 tag, Type type, quint32 n, quint32 value) {
+		put16(header, tag);
+		put16(header, type);
+		put32(header, n);
+		put32(header, value);
+	};
+	entry(256, LONG, 1, _width);
+	entry(257, LONG, 1, _height);
+	entry(258, SHORT, 3, bits);
+	entry(259, SHORT, 1, 1);	//Без сжатия
+	entry(262, SHORT, 1, 2);	//RGB
+	entry(277, SHORT, 1, 3);
+	entry(284, SHORT, 1, 1);
+	entry(322, LONG, 1, TILE);
+	entry(323, LONG, 1, TILE);
+	//Единственное значение хранится в самой записи
+	entry(324, LONG, count, (count > 1)? offsets: quint32(data));
+	entry(325, LONG, count, (count > 1)? counts: quint32(tileBytes));
+	put32(header, 0);
+	for (int i = 0; i < 4; ++ i) put16(header, 8);
+	if (count > 1) {
+		for (quint32 i = 0; i < count; ++ i) put32(header, quint32(data + i * tileBytes));
+		for (quint32 i = 0; i < count; ++ i) put32(header, quint32(tileBytes));
+	}
+	if (device->write(header) != header.size()) {
+		return fail(device->errorString());
+	}
+
+	//Пачка плиток строится параллельно и пишется по порядку
+	const quint32 batch = std::max(1, 2 * QThread::idealThreadCount());
+	std::vector<QByteArray> tiles;
+	for (quint32 first = 0; first < count; first += batch) {
+		tiles.assign(std::min(batch, count - first), QByteArray());
+		std::vector<quint32> jobs(tiles.size());
+		for (size_t i = 0; i < jobs.size(); ++ i) jobs[i] = i;
+		QtConcurrent::blockingMap(jobs, [&](quint32 i) {
+			quint32 k = first + i;
+			QImage image = renderTile(k % across, k / across);
+			QByteArray &bytes = tiles[i];
+			bytes.resize(tileBytes);
+			char *out = bytes.data();
+			for (int y = 0; y < TILE; ++ y) {
+				auto *line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+				for (int x = 0; x < TILE; ++ x) {
+					*out ++ = char(qRed(line[x]));
+					*out ++ = char(qGreen(line[x]));
+					*out ++ = char(qBlue(line[x]));
+				}
+			}
+		});
+		for (const auto &bytes : tiles) {
+			if (device->write(bytes) != bytes.size()) {
+				return fail(device->errorString());
+			}
+		}
+		quint32 done = first + tiles.size();
+		if (progress && !progress(done, count)) {
+			return fail("Operation canceled!");
+		}
+	}
+	return true;
+}
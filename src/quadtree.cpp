@@ -0,0 +1,204 @@
+#include <quadtree.hpp>
+#include <trace.hpp>
+#include <QCryptographicHash>
+#include <QtConcurrent>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+
+static QRectF quarter(const QRectF &rect, int q)
+{
+	qreal w = rect.width() / 2., h = rect.height() / 2.;
+	return QRectF(rect.left() + (q & 1) * w, rect.top() + (q >> 1) * h, w, h);
+}
+
+struct QuadTree::Builder {
+	struct Task {
+		qint32 _slot;
+		QRectF _rect;
+		int _level;
+	};
+
+	Builder(const Classifier &classifier, int depth):
+	    classifier(classifier), depth(depth) {}
+
+	void fill(qint32 slot, const QRectF &rect, int level)
+	{
+		Outcome outcome;
+		if (classifier.classify(rect, outcome)) {
+			nodes[slot]._leaf = leaves.size();
+			leaves.push_back(outcome);
+			return;
+		}
+		if (level >= depth) return;
+		if (tasks && (level >= split)) {
+			tasks->push_back({slot, rect, level});
+			return;
+		}
+		//Потомки одного узла лежат подряд
+		qint32 first = nodes.size();
+		nodes.resize(first + 4);
+		nodes[slot]._child = first;
+		for (int q = 0; q < 4; ++ q) {
+			fill(first + q, quarter(rect, q), level + 1);
+		}
+	}
+
+	const Classifier &classifier;
+	int depth;
+	std::vector<Node> nodes;
+	std::vector<Outcome> leaves;
+	std::vector<Task> *tasks = nullptr;
+	int split = 0;
+};
+
+std::shared_ptr<QuadTree> QuadTree::build(const Classifier &classifier, int depth)
+{
+	auto tree = std::make_shared<QuadTree>();
+	tree->_bounds = classifier.getBase().bounds();
+
+	//Первые уровни определяют независимые поддеревья
+	std::vector<Builder::Task> tasks;
+	Builder top(classifier, depth);
+	top.tasks = &tasks;
+	top.split = 3;
+	top.nodes.resize(1);
+	top.fill(0, tree->_bounds, 0);
+
+	std::vector<Builder> parts(tasks.size(), Builder(classifier, depth));
+	std::vector<int> jobs(tasks.size());
+	for (size_t i = 0; i < jobs.size(); ++ i) jobs[i] = i;
+	QtConcurrent::blockingMap(jobs, [&](int i) {
+		TRACE_SPAN("QuadTree::fill");
+		const auto &task = tasks[i];
+		parts[i].nodes.resize(1);
+		parts[i].fill(0, task._rect, task._level);
+	});
+
+	//Сшиваем поддеревья: корень части занимает отложенную ячейку
+	tree->_nodes = std::move(top.nodes);
+	tree->_leaves = std::move(top.leaves);
+	for (size_t i = 0; i < parts.size(); ++ i) {
+		auto &part = parts[i];
+		qint32 base = qint32(tree->_nodes.size()) - 1;
+		qint32 leaf = tree->_leaves.size();
+		for (auto &node : part.nodes) {
+			if (node._child >= 0) node._child += base;
+			if (node._leaf >= 0) node._leaf += leaf;
+		}
+		tree->_nodes[tasks[i]._slot] = part.nodes.front();
+		tree->_nodes.insert(tree->_nodes.end(), part.nodes.begin() + 1, part.nodes.end());
+		tree->_leaves.insert(tree->_leaves.end(), part.leaves.begin(), part.leaves.end());
+	}
+	return tree;
+}
+
+bool QuadTree::find(const QPointF &point, Outcome &outcome) const
+{
+	if (_nodes.empty()) return false;
+	if (!_bounds.contains(point)) {
+		outcome = Outcome();
+		return true;
+	}
+	QRectF rect = _bounds;
+	const Node *node = &_nodes.front();
+	while (node->_child >= 0) {
+		QPointF c = rect.center();
+		int q = (point.x() >= c.x()) | ((point.y() >= c.y()) << 1);
+		rect = quarter(rect, q);
+		node = &_nodes[node->_child + q];
+	}
+	if (node->_leaf < 0) return false;
+	outcome = _leaves[node->_leaf];
+	return true;
+}
+
+static void hashNode(QCryptographicHash &hash, const TreeNode *node)
+{
+	qreal center[2] = {node->_center.x(), node->_center.y()};
+	char flags = node->_empty[0] | (node->_empty[1] << 1) |
+	             (bool(node->_branch[0]) << 2) | (bool(node->_branch[1]) << 3) |
+	             (node->_exit << 4);
+	hash.addData(reinterpret_cast<const char*>(center), sizeof(center));
+	hash.addData(&flags, 1);
+	for (auto &next : node->_branch) {
+		if (next) hashNode(hash, next.get());
+	}
+}
+
+QByteArray QuadTree::fingerprint(const TreeDocument &doc)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(reinterpret_cast<const char*>(doc._radius.data()),
+	             doc._radius.size() * sizeof(qreal));
+	if (doc._root) hashNode(hash, doc._root.get());
+	return hash.result();
+}
+
+bool QuadTree::save(const QString &fileName) const
+{
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly)) return false;
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream << MAGIC << VERSION << _fingerprint << _bounds;
+	stream << quint32(_nodes.size());
+	for (const auto &node : _nodes) {
+		stream << node._child << node._leaf;
+	}
+	stream << quint32(_leaves.size());
+	for (const auto &leaf : _leaves) {
+		stream << qint32(leaf._kind) << qint32(leaf._depth) << leaf._path;
+	}
+	if (stream.status() != QDataStream::Ok) {
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
+
+std::shared_ptr<QuadTree> QuadTree::load(const QString &fileName, const QByteArray &fingerprint)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) return nullptr;
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	quint32 magic;
+	quint16 version;
+	auto tree = std::make_shared<QuadTree>();
+	stream >> magic >> version;
+	if ((magic != MAGIC) || (version != VERSION)) return nullptr;
+	//Разбиение от другого дерева не используем
+	stream >> tree->_fingerprint >> tree->_bounds;
+	if (tree->_fingerprint != fingerprint) return nullptr;
+	quint32 count;
+	stream >> count;
+	if (stream.status() != QDataStream::Ok || count > file.size() / 8) return nullptr;
+	tree->_nodes.resize(count);
+	for (auto &node : tree->_nodes) {
+		stream >> node._child >> node._leaf;
+	}
+	stream >> count;
+	if (stream.status() != QDataStream::Ok || count > file.size() / 16) return nullptr;
+	tree->_leaves.resize(count);
+	for (auto &leaf : tree->_leaves) {
+		qint32 kind, depth;
+		stream >> kind >> depth >> leaf._path;
+		leaf._kind = Outcome::Kind(kind);
+		leaf._depth = depth;
+	}
+	if (stream.status() != QDataStream::Ok) return nullptr;
+
+	//Ссылки должны оставаться внутри массивов
+	const qint32 nodes = tree->_nodes.size(), leaves = tree->_leaves.size();
+	//Потомки всегда записаны после родителя, поэтому циклов нет
+	for (qint32 i = 0; i < nodes; ++ i) {
+		const auto &node = tree->_nodes[i];
+		if ((node._child >= nodes - 3) || (node._leaf >= leaves) ||
+		    ((node._child >= 0) && (node._child <= i)) ||
+		    (node._child < -1) || (node._leaf < -1)) {
+			return nullptr;
+		}
+	}
+	return tree;
+}
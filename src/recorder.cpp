@@ -0,0 +1,228 @@
+#include <recorder.hpp>
+#include <graphicsscene.hpp>
+#include <treefile.hpp>
+#include <treetask.hpp>
+#include <QElapsedTimer>
+#include <QBuffer>
+
+Recorder::~Recorder()
+{
+	close();
+}
+
+bool Recorder::open(const QString &fileName, const GraphicsScene *scene)
+{
+	close();
+	_file.setFileName(fileName);
+	if (!_file.open(QIODevice::WriteOnly)) return false;
+	_stream.setDevice(&_file);
+	_stream.setVersion(QDataStream::Qt_5_0);
+
+	//Начальное состояние: дерево, режим, флаги и текущий путь
+	//с положениями окружностей, включая несохраненные узлы
+	QByteArray data;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+	TreeFile::write(&buffer, scene->getDocument());
+	auto centers = scene->getPathCenters();
+	_stream << MAGIC << VERSION << qint32(scene->getMode()) << data
+	        << scene->isFilledArea() << scene->isVisibleKnots()
+	        << QByteArray::fromStdString(scene->getNodePath())
+	        << quint32(centers.size());
+	for (const auto &center : centers) _stream << center;
+	return true;
+}
+
+void Recorder::close()
+{
+	if (!_file.isOpen()) return;
+	_stream.setDevice(nullptr);
+	_file.close();
+}
+
+const char* Recorder::name(Op op)
+{
+	static const char *names[Count] = {
+		"Load", "Start", "Mode", "Fill", "Knots",
+		"GoToNext", "GoToBack", "GoToInv", "GoToPath",
+		"PlaceToChord", "PlaceToLocal", "PlaceToPoint",
+		"SavePath", "Reset", "Simplify", "Test",
+		"Grab", "Drag", "Release", "Knot", "Drop", "Zoom",
+		"Exits"
+	};
+	return (op < Count)? names[op]: "";
+}
+
+bool Recorder::replay(const QString &fileName, GraphicsScene *scene,
+                      std::vector<Timing> &timing, QString *error)
+{
+	auto fail = [error](const QString &message) {
+		if (error) *error = message;
+		return false;
+	};
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return fail(file.errorString());
+	}
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	quint32 magic = 0;
+	quint16 version = 0;
+	qint32 mode = 0;
+	QByteArray data;
+	stream >> magic >> version;
+	if ((magic != MAGIC) || (version != VERSION)) {
+		return fail("Unknown session format!");
+	}
+	bool filled = false, knots = true;
+	QByteArray path;
+	quint32 count = 0;
+	stream >> mode >> data >> filled >> knots >> path >> count;
+	std::vector<QPointF> centers;
+	for (quint32 i = 0; (i < count) && (stream.status() == QDataStream::Ok); ++ i) {
+		QPointF center;
+		stream >> center;
+		centers.push_back(center);
+	}
+	if (stream.status() != QDataStream::Ok) {
+		return fail("Truncated session!");
+	}
+	TreeDocument doc;
+	QString message;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::ReadOnly);
+	if (!TreeFile::read(&buffer, doc, nullptr, &message)) {
+		return fail(message);
+	}
+	scene->setDocument(std::move(doc));
+	scene->setFilledArea(filled);
+	scene->setVisibleKnots(knots);
+	//Путь восстанавливаем в режиме дерева, режим проверки строит свой
+	scene->setMode(GraphicsScene::Mode::Tree);
+	scene->restorePath(path.toStdString(), centers);
+	if (GraphicsScene::Mode(mode) != GraphicsScene::Mode::Tree) {
+		scene->setMode(GraphicsScene::Mode(mode));
+	}
+	scene->flush();
+
+	timing.assign(Count, Timing());
+	QElapsedTimer timer;
+	while (!stream.atEnd()) {
+		quint8 code;
+		stream >> code;
+		if (code >= Count) return fail("Unknown operation!");
+		Op op = Op(code);
+		auto run = [&](auto &&call) {
+			timer.start();
+			call();
+			scene->flush();
+			qint64 elapsed = timer.nsecsElapsed();
+			auto &t = timing[op];
+			++ t._count;
+			t._total += elapsed;
+			t._max = std::max(t._max, elapsed);
+		};
+		bool flag = false;
+		QPointF point;
+		qint32 value = 0;
+		qreal factor = 1.;
+		QString name;
+		switch (op) {
+		case Load:
+			stream >> name;
+			//Загрузка идет тем же путем, что и в окне: с журналом правок
+			run([&]() {
+				TreeDocument doc;
+				if (TreeTask::read(name, doc) >= 0) {
+					scene->setDocument(std::move(doc));
+				}
+			});
+			break;
+		case Start:
+			run([&]() { scene->start(); });
+			break;
+		case Mode:
+			stream >> value;
+			run([&]() { scene->setMode(GraphicsScene::Mode(value)); });
+			break;
+		case Fill:
+			stream >> flag;
+			run([&]() { scene->setFilledArea(flag); });
+			break;
+		case Knots:
+			stream >> flag;
+			run([&]() { scene->setVisibleKnots(flag); });
+			break;
+		case GoToNext:
+			stream >> flag;
+			run([&]() { scene->goToNext(flag); });
+			break;
+		case GoToBack:
+			run([&]() { scene->goToBack(); });
+			break;
+		case GoToInv:
+			run([&]() { scene->goToInv(); });
+			break;
+		case GoToPath:
+			stream >> path;
+			run([&]() { scene->goToPath(path.toStdString()); });
+			break;
+		case PlaceToChord:
+			stream >> flag;
+			run([&]() { scene->placeToChord(flag); });
+			break;
+		case PlaceToLocal:
+			stream >> point >> flag;
+			run([&]() { scene->placeToLocal(point, flag); });
+			break;
+		case PlaceToPoint:
+			stream >> point;
+			run([&]() { scene->placeToPoint(point); });
+			break;
+		case SavePath:
+			run([&]() { scene->savePath(); });
+			break;
+		case Reset:
+			run([&]() { scene->reset(); });
+			break;
+		case Simplify:
+			run([&]() { scene->simplify(); });
+			break;
+		case Test:
+			stream >> point;
+			run([&]() { scene->test(point); });
+			break;
+		case Grab:
+			stream >> value >> point;
+			run([&]() { scene->grabCircle(value, point); });
+			break;
+		case Drag:
+			stream >> point;
+			run([&]() { scene->dragBy(point); });
+			break;
+		case Release:
+			run([&]() { scene->releaseCircle(); });
+			break;
+		case Knot:
+			stream >> point;
+			run([&]() { scene->selectKnot(point); });
+			break;
+		case Drop:
+			run([&]() { scene->dropSelection(); });
+			break;
+		case Zoom:
+			stream >> point >> factor;
+			run([&]() { scene->zoom(point, factor); });
+			break;
+		case Exits:
+			run([&]() { scene->earlyExit(); });
+			break;
+		default:
+			break;
+		}
+		if (stream.status() != QDataStream::Ok) {
+			return fail("Truncated session!");
+		}
+	}
+	return true;
+}
@@ -0,0 +1,46 @@
+#include <simplifier.hpp>
+
+qint64 Simplifier::size(const TreeNode *node)
+{
+	if (!node) return 0;
+	return 1 + size(node->_branch[0].get()) +
+	           size(node->_branch[1].get());
+}
+
+qint64 Simplifier::simplify(TreeNode *root) const
+{
+	qint64 removed = 0;
+	if (!root) return removed;
+	Cell cell(_base);
+	simplify(root, cell, removed);
+	return removed;
+}
+
+bool Simplifier::simplify(TreeNode *node, Cell &cell, qint64 &removed) const
+{
+	if (node->_index + 1 >= int(_radius.size())) return false;
+
+	//Окружность, не задевающая ячейку или накрывающая ее целиком,
+	//оставляет одну из ветвей пустой
+	Disk disk{node->_center, _radius.at(node->_index)};
+	bool changed = false;
+	for (int i = 0; i < 2; ++ i) {
+		cell.push(disk, i);
+		auto &next = node->_branch[i];
+		if (cell.isEmpty()) {
+			if (!node->_empty[i] || next) {
+				removed += size(next.get());
+				node->_empty[i] = true;
+				next.reset();
+				changed = true;
+			}
+		}
+		else
+		if (next && simplify(next.get(), cell, removed)) {
+			changed = true;
+		}
+		cell.pop();
+	}
+	if (changed) node->reset();
+	return changed;
+}
@@ -0,0 +1,74 @@
+#include <solver.hpp>
+#include <algorithm>
+
+std::shared_ptr<TreeNode> Solver::solve(const QDeadlineTimer &deadline) const
+{
+	if (_radius.size() < 2) return nullptr;
+	auto root = std::make_shared<TreeNode>();
+	Cell cell(_base);
+	if (!build(root.get(), cell, deadline)) return nullptr;
+	return root;
+}
+
+bool Solver::build(TreeNode *node, Cell &cell, const QDeadlineTimer &deadline) const
+{
+	if (deadline.hasExpired()) return false;
+
+	node->_fixed = true;
+	auto points = cell.samples();
+	Disk all = enclose(points);
+	qreal r = _radius.at(node->_index);
+	if (node->_index + 1 >= int(_radius.size())) {
+		node->_center = all._center;
+		return true;
+	}
+
+	//Выбираем центр, после которого большая из частей ячейки наименьшая
+	auto spread = [](qreal x1, qreal y1, qreal x2, qreal y2) {
+		return (x1 > x2)? 0.: std::hypot(x2 - x1, y2 - y1);
+	};
+	auto score = [&](const QPointF &c) {
+		qreal in[4] = {1e9, 1e9, -1e9, -1e9}, out[4] = {1e9, 1e9, -1e9, -1e9};
+		Disk disk{c, r};
+		for (const auto &p : points) {
+			qreal *b = disk.contains(p)? in: out;
+			b[0] = std::min(b[0], p.x()); b[1] = std::min(b[1], p.y());
+			b[2] = std::max(b[2], p.x()); b[3] = std::max(b[3], p.y());
+		}
+		return std::max(spread(in[0], in[1], in[2], in[3]),
+		                spread(out[0], out[1], out[2], out[3]));
+	};
+	QPointF best = all._center;
+	qreal bestScore = score(best);
+	QRectF area = cell.bounds().adjusted(-r, -r, r, r);
+	for (int i = 0; i <= CANDIDATES; ++ i) {
+		for (int j = 0; j <= CANDIDATES; ++ j) {
+			QPointF c(area.left() + area.width() * i / CANDIDATES,
+			          area.top() + area.height() * j / CANDIDATES);
+			qreal s = score(c);
+			if (s < bestScore) {
+				bestScore = s;
+				best = c;
+			}
+		}
+	}
+	node->_center = best;
+
+	Disk disk{best, r};
+	for (int i = 0; i < 2; ++ i) {
+		cell.push(disk, i);
+		bool ok = true;
+		if (cell.isEmpty()) {
+			node->_empty[i] = true;
+		}
+		else {
+			auto next = std::make_shared<TreeNode>();
+			next->_index = node->_index + 1;
+			node->_branch[i] = next;
+			ok = build(next.get(), cell, deadline);
+		}
+		cell.pop();
+		if (!ok) return false;
+	}
+	return true;
+}
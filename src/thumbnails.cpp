@@ -0,0 +1,215 @@
+#include <thumbnails.hpp>
+#include <trace.hpp>
+#include <QtConcurrent>
+#include <QPainter>
+#include <QPixmap>
+#include <QRegExp>
+#include <QBuffer>
+
+Thumbnails::Thumbnails(const Source &source, const Revision &revision,
+                       qint64 budget, QObject *parent):
+    QObject(parent), _source(source), _revision(revision), _budget(budget)
+{
+	//Фоновое построение не должно отнимать потоки у карты исходов
+	_pool.setMaxThreadCount(1);
+	_settle.setSingleShot(true);
+	_settle.setInterval(300);
+	connect(&_settle, &QTimer::timeout, this, [this]() {
+		if (_taken != _seen) emit changed();
+	});
+}
+
+Thumbnails::~Thumbnails()
+{
+	_pool.clear();
+	_pool.waitForDone();
+}
+
+void Thumbnails::take()
+{
+	_taken = _seen;
+	//Новый снимок делает все изображения устаревшими
+	auto snapshot = _source? _source(): nullptr;
+	if (snapshot == _snapshot) return;
+	_snapshot = snapshot;
+	++ _generation;
+	_pool.clear();
+	_cache.clear();
+	_order.clear();
+	_pending.clear();
+	_bytes = 0;
+}
+
+QImage Thumbnails::find(const std::string &path)
+{
+	//Во время перетаскивания правка идет каждый кадр: до паузы
+	//отдаем изображения прежнего снимка
+	quint64 revision = _revision? _revision(): 0;
+	if (revision != _seen) {
+		_seen = revision;
+		_settle.start();
+	}
+	if (!_snapshot || (!_settle.isActive() && (_taken != _seen))) take();
+	if (!_snapshot) return QImage();
+
+	auto it = _cache.find(path);
+	if (it != _cache.end()) {
+		_order.splice(_order.begin(), _order, it->second._order);
+		return it->second._image;
+	}
+	if (!_pending.insert(path).second) return QImage();
+	QtConcurrent::run(&_pool, [this, snapshot = _snapshot, path, generation = _generation]() {
+		TRACE_SPAN("Thumbnails::render");
+		QImage image = render(*snapshot, path);
+		QMetaObject::invokeMethod(this, "store", Qt::QueuedConnection,
+		                          Q_ARG(QString, QString::fromStdString(path)),
+		                          Q_ARG(QImage, image),
+		                          Q_ARG(qulonglong, generation));
+	});
+	return QImage();
+}
+
+void Thumbnails::store(const QString &path, const QImage &image, qulonglong generation)
+{
+	if (generation != _generation) return;
+	std::string key = path.toStdString();
+	_pending.erase(key);
+	if (_cache.count(key)) return;
+	_order.push_front(key);
+	_cache[key] = {image, _order.begin()};
+	_bytes += image.bytesPerLine() * image.height();
+	evict();
+	emit ready(path);
+}
+
+void Thumbnails::setBudget(qint64 budget)
+{
+	_budget = budget;
+	evict();
+}
+
+void Thumbnails::evict()
+{
+	//Последнее запрошенное изображение оставляем даже сверх бюджета
+	while ((_bytes > _budget) && (_order.size() > 1)) {
+		auto it = _cache.find(_order.back());
+		_bytes -= it->second._image.bytesPerLine() * it->second._image.height();
+		_cache.erase(it);
+		_order.pop_back();
+	}
+}
+
+QImage Thumbnails::render(const Classifier &snapshot, const std::string &path)
+{
+	QImage image(SIZE, SIZE, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::white);
+	const Disk &base = snapshot.getBase();
+	const auto &radius = snapshot.getRadius();
+	qreal scale = (SIZE - 2) / (2. * base._radius);
+	auto toImage = [&](const QPointF &p) {
+		return QPointF(SIZE / 2. + (p.x() - base._center.x()) * scale,
+		               SIZE / 2. - (p.y() - base._center.y()) * scale);
+	};
+
+	//Проходим путь, собирая ячейку
+	Cell cell(base);
+	std::vector<Disk> disks;
+	const TreeNode *node = snapshot.getRoot().get();
+	for (char c : path) {
+		if (!node || (node->_index + 1 >= int(radius.size()))) break;
+		bool ans = (c == '1');
+		disks.push_back({node->_center, radius[node->_index]});
+		cell.push(disks.back(), ans);
+		node = node->_branch[ans].get();
+	}
+	for (int y = 0; y < SIZE; ++ y) {
+		auto *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+		for (int x = 0; x < SIZE; ++ x) {
+			QPointF p(base._center.x() + (x + .5 - SIZE / 2.) / scale,
+			          base._center.y() - (y + .5 - SIZE / 2.) / scale);
+			if (cell.contains(p)) line[x] = qRgb(255, 240, 160);
+		}
+	}
+
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.setBrush(Qt::NoBrush);
+	auto circle = [&](const Disk &disk) {
+		qreal r = disk._radius * scale;
+		painter.drawEllipse(toImage(disk._center), r, r);
+	};
+	QPen pen(QColor(127, 127, 127), 1.);
+	pen.setDashPattern({1., 2.});
+	painter.setPen(pen);
+	circle(base);
+	painter.setPen(QPen(QColor(160, 160, 160), 1.));
+	for (const auto &disk : disks) circle(disk);
+
+	//Узел в конце пути выделяем, отсутствующий отмечаем рамкой
+	if (node) {
+		painter.setPen(QPen(QColor(0, 0, 255), 1.5));
+		circle({node->_center, radius.at(node->_index)});
+	}
+	else {
+		painter.setPen(QPen(QColor(255, 0, 0), 2.));
+		painter.drawRect(QRectF(1., 1., SIZE - 2., SIZE - 2.));
+	}
+	return image;
+}
+
+QString Thumbnails::toolTip(const QImage &image)
+{
+	QByteArray png;
+	QBuffer buffer(&png);
+	image.save(&buffer, "PNG");
+	return QString("<img src=\"data:image/png;base64,%1\" width=\"%2\" height=\"%2\"/>")
+	       .arg(QString::fromLatin1(png.toBase64())).arg(2 * SIZE);
+}
+
+ThumbnailModel::ThumbnailModel(Thumbnails *thumbnails, QObject *parent):
+    QStringListModel(parent), _thumbnails(thumbnails)
+{
+	connect(_thumbnails, &Thumbnails::ready, this, &ThumbnailModel::refresh);
+	connect(_thumbnails, &Thumbnails::changed, this, &ThumbnailModel::refreshAll);
+}
+
+std::string ThumbnailModel::pathOf(const QString &text)
+{
+	for (const auto &word : text.split(' ', QString::SkipEmptyParts)) {
+		if (QRegExp("[01x]+").exactMatch(word)) {
+			return word.toStdString();
+		}
+	}
+	return std::string();
+}
+
+QVariant ThumbnailModel::data(const QModelIndex &index, int role) const
+{
+	if ((role != Qt::DecorationRole) && (role != Qt::ToolTipRole)) {
+		return QStringListModel::data(index, role);
+	}
+	QString text = QStringListModel::data(index, Qt::DisplayRole).toString();
+	std::string path = pathOf(text);
+	path = path.substr(0, path.find('x'));
+	QImage image = _thumbnails->find(path);
+	if (image.isNull()) return QVariant();
+	if (role == Qt::DecorationRole) return QPixmap::fromImage(image);
+	return Thumbnails::toolTip(image);
+}
+
+void ThumbnailModel::refresh(const QString &path)
+{
+	for (int row = 0; row < rowCount(); ++ row) {
+		QModelIndex index = this->index(row);
+		std::string text = pathOf(index.data(Qt::DisplayRole).toString());
+		if (QString::fromStdString(text.substr(0, text.find('x'))) == path) {
+			emit dataChanged(index, index, {Qt::DecorationRole, Qt::ToolTipRole});
+		}
+	}
+}
+
+void ThumbnailModel::refreshAll()
+{
+	if (!rowCount()) return;
+	emit dataChanged(index(0), index(rowCount() - 1), {Qt::DecorationRole, Qt::ToolTipRole});
+}
@@ -0,0 +1,245 @@
+#include <trace.hpp>
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QThread>
+#include <QMutex>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct Event {
+	const char *_name;
+	qint64 _begin;	//нс
+	qint64 _end;
+};
+
+//Ячейка кольца с номером версии: нечетный - запись идет, четный 2n + 2 -
+//в ячейке событие номер n. Читатель сверяет номер до и после чтения,
+//поэтому выгрузка не мешает потокам, продолжающим писать
+struct Slot {
+	std::atomic<quint64> _seq{0};
+	std::atomic<const char*> _name{nullptr};
+	std::atomic<qint64> _begin{0};
+	std::atomic<qint64> _end{0};
+};
+
+//Буфер пишет только свой поток; число записей публикуется после события
+struct Buffer {
+	static constexpr quint32 CAPACITY = 1 << 16;
+
+	explicit Buffer(int tid, const QString &name):
+	    _slots(CAPACITY), _tid(tid), _name(name) {}
+
+	//Читает событие номер index, если оно еще не перезаписано
+	bool read(quint64 index, Event &event) const {
+		const Slot &slot = _slots[index % CAPACITY];
+		quint64 seq = slot._seq.load(std::memory_order_acquire);
+		if (seq != 2 * index + 2) return false;
+		event._name = slot._name.load(std::memory_order_relaxed);
+		event._begin = slot._begin.load(std::memory_order_relaxed);
+		event._end = slot._end.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot._seq.load(std::memory_order_relaxed) == seq;
+	}
+
+	std::vector<Slot> _slots;
+	std::atomic<quint64> _count{0};
+	std::atomic<quint64> _start{0};	//Записи до этого номера очищены
+	int _tid;
+	QString _name;
+	bool _free = false;		//Поток завершен, записи выгружены
+};
+
+//Буфер завершенного потока ждет выгрузки, затем отдается новому потоку.
+//Потоки пулов и задач создаются постоянно, без этого память росла бы
+struct Registry {
+	static constexpr size_t LIMIT = 32;
+
+	QMutex _mutex;
+	std::vector<std::unique_ptr<Buffer>> _buffers;
+	std::deque<Buffer*> _retired;	//Завершенные, еще не выгруженные
+	std::vector<Buffer*> _free;
+	int _tid = 0;
+};
+
+Registry& registry()
+{
+	static Registry instance;
+	return instance;
+}
+
+Buffer* acquire()
+{
+	auto &reg = registry();
+	QMutexLocker lock(&reg._mutex);
+	int tid = ++ reg._tid;
+	QThread *thread = QThread::currentThread();
+	QString name = thread->objectName();
+	if (QCoreApplication::instance() &&
+	    (thread == QCoreApplication::instance()->thread())) {
+		name = "main";
+	}
+	if (name.isEmpty()) name = QString("worker %1").arg(tid);
+
+	Buffer *buffer = nullptr;
+	if (!reg._free.empty()) {
+		buffer = reg._free.back();
+		reg._free.pop_back();
+	}
+	else
+	if ((reg._buffers.size() >= Registry::LIMIT) && !reg._retired.empty()) {
+		//Сверх предела жертвуем самыми старыми невыгруженными записями
+		buffer = reg._retired.front();
+		reg._retired.pop_front();
+	}
+	if (!buffer) {
+		reg._buffers.push_back(std::make_unique<Buffer>(tid, name));
+		return reg._buffers.back().get();
+	}
+	//Прежний владелец завершен, счетчик теперь пишет только этот поток
+	buffer->_start.store(buffer->_count.load(std::memory_order_relaxed),
+	                     std::memory_order_release);
+	buffer->_tid = tid;
+	buffer->_name = name;
+	buffer->_free = false;
+	return buffer;
+}
+
+void retire(Buffer *buffer)
+{
+	auto &reg = registry();
+	QMutexLocker lock(&reg._mutex);
+	reg._retired.push_back(buffer);
+}
+
+//Возвращает буфер при завершении потока
+struct Holder {
+	~Holder() {
+		if (_buffer) retire(_buffer);
+		_buffer = nullptr;
+	}
+	Buffer *_buffer = nullptr;
+};
+
+Buffer* local()
+{
+	thread_local Holder holder;
+	if (!holder._buffer) holder._buffer = acquire();
+	return holder._buffer;
+}
+
+QByteArray escape(const QString &text)
+{
+	QByteArray result;
+	for (char c : text.toUtf8()) {
+		if ((c == '"') || (c == '\\')) result += '\\';
+		if (uchar(c) >= 0x20) result += c;
+	}
+	return result;
+}
+
+}
+
+std::atomic<bool> Trace::_enabled{false};
+
+qint64 Trace::now()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char *name, qint64 begin, qint64 end)
+{
+	Buffer *buffer = local();
+	quint64 count = buffer->_count.load(std::memory_order_relaxed);
+	Slot &slot = buffer->_slots[count % Buffer::CAPACITY];
+	slot._seq.store(2 * count + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot._name.store(name, std::memory_order_relaxed);
+	slot._begin.store(begin, std::memory_order_relaxed);
+	slot._end.store(end, std::memory_order_relaxed);
+	slot._seq.store(2 * count + 2, std::memory_order_release);
+	buffer->_count.store(count + 1, std::memory_order_release);
+}
+
+void Trace::clear()
+{
+	//Счетчик меняет только поток-владелец, очистка лишь сдвигает начало
+	auto &reg = registry();
+	QMutexLocker lock(&reg._mutex);
+	for (auto &buffer : reg._buffers) {
+		buffer->_start.store(buffer->_count.load(std::memory_order_acquire),
+		                     std::memory_order_release);
+	}
+}
+
+bool Trace::dump(const QString &fileName)
+{
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly)) return false;
+
+	//Время отсчитывается от самого раннего сохраненного интервала
+	auto &reg = registry();
+	QMutexLocker lock(&reg._mutex);
+	//Снимаем события сразу: потоки могут писать и во время выгрузки,
+	//перезаписанные к этому моменту ячейки пропускаются
+	std::vector<std::vector<Event>> events;
+	qint64 origin = std::numeric_limits<qint64>::max();
+	for (auto &buffer : reg._buffers) {
+		events.emplace_back();
+		if (buffer->_free) continue;
+		quint64 count = buffer->_count.load(std::memory_order_acquire);
+		quint64 first = (count > Buffer::CAPACITY)? count - Buffer::CAPACITY: 0;
+		first = std::max(first, buffer->_start.load(std::memory_order_acquire));
+		for (quint64 i = first; i < count; ++ i) {
+			Event e;
+			if (!buffer->read(i, e)) continue;
+			origin = std::min(origin, e._begin);
+			events.back().push_back(e);
+		}
+	}
+	QByteArray text = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool comma = false;
+	auto separate = [&]() {
+		if (comma) text += ",\n";
+		comma = true;
+	};
+	//Записи завершенных потоков сняты, их буферы можно отдавать
+	for (auto *buffer : reg._retired) {
+		buffer->_free = true;
+		reg._free.push_back(buffer);
+	}
+	reg._retired.clear();
+	for (size_t b = 0; b < events.size(); ++ b) {
+		const auto &buffer = reg._buffers[b];
+		if (buffer->_free && events[b].empty()) continue;
+		separate();
+		text += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" +
+		        QByteArray::number(buffer->_tid) + ",\"args\":{\"name\":\"" +
+		        escape(buffer->_name) + "\"}}";
+		for (const Event &e : events[b]) {
+			separate();
+			text += "{\"name\":\"" + escape(e._name) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":" +
+			        QByteArray::number(buffer->_tid) + ",\"ts\":" +
+			        QByteArray::number((e._begin - origin) / 1.e3, 'f', 3) + ",\"dur\":" +
+			        QByteArray::number((e._end - e._begin) / 1.e3, 'f', 3) + "}";
+			if (text.size() >= (1 << 16)) {
+				if (file.write(text) != text.size()) {
+					file.cancelWriting();
+					return false;
+				}
+				text.clear();
+			}
+		}
+	}
+	text += "\n]}\n";
+	if (file.write(text) != text.size()) {
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
@@ -0,0 +1,228 @@
+#include <treediff.hpp>
+#include <jsonreader.hpp>
+#include <cmath>
+
+namespace {
+
+using Token = JsonReader::Token;
+
+struct Side {
+	explicit Side(QIODevice *device): json(device) {}
+
+	//Пустой объект и null обозначают отсутствующий узел
+	bool open(Token token, bool &exists)
+	{
+		exists = false;
+		if (token == JsonReader::Null) return true;
+		if (token != JsonReader::BeginObject) return false;
+		if (json.peek() == JsonReader::EndObject) {
+			json.next();
+			return true;
+		}
+		exists = true;
+		return true;
+	}
+
+	bool center(Token token, QPointF &point)
+	{
+		if (token != JsonReader::BeginArray ||
+		    json.next() != JsonReader::Number) {
+			return false;
+		}
+		qreal x = json.number();
+		if (json.next() != JsonReader::Number) return false;
+		qreal y = json.number();
+		if (json.next() != JsonReader::EndArray) return false;
+		point = QPointF(x, y);
+		return true;
+	}
+
+	//Читаем ключи узла до массива ветвей или до конца узла
+	bool seek(QPointF &point, bool &branch)
+	{
+		branch = false;
+		for (;;) {
+			Token token = json.next();
+			if (token == JsonReader::EndObject) return true;
+			if (token != JsonReader::String) return false;
+			QByteArray key = json.text();
+			token = json.next();
+			if (key == "center") {
+				if (!center(token, point)) return false;
+			}
+			else
+			if (key == "branch") {
+				branch = true;
+				return token == JsonReader::BeginArray;
+			}
+			else
+			if (!json.skip(token)) {
+				return false;
+			}
+		}
+	}
+
+	Token element(bool &list)
+	{
+		if (!list) return JsonReader::Null;
+		Token token = json.next();
+		if (token == JsonReader::EndArray) {
+			list = false;
+			return JsonReader::Null;
+		}
+		return token;
+	}
+
+	//Дочитываем узел после массива ветвей
+	bool close(bool list, QPointF &point)
+	{
+		if (list && json.next() != JsonReader::EndArray) {
+			return false;
+		}
+		bool branch;
+		return seek(point, branch) && !branch;
+	}
+
+	//Пропускаем поддерево, подсчитывая его узлы
+	bool subtree(qint64 &count, QPointF &point)
+	{
+		bool branch;
+		if (!seek(point, branch)) return false;
+		++ count;
+		if (!branch) return true;
+		bool list = true;
+		for (int i = 0; i < 2; ++ i) {
+			bool exists;
+			QPointF next;
+			if (!open(element(list), exists)) return false;
+			if (exists && !subtree(count, next)) return false;
+		}
+		return close(list, point);
+	}
+
+	bool search(Token &token)
+	{
+		if (json.next() != JsonReader::BeginObject) return false;
+		for (;;) {
+			token = json.next();
+			if (token == JsonReader::EndObject) {
+				token = JsonReader::Null;
+				return true;
+			}
+			if (token != JsonReader::String) return false;
+			QByteArray key = json.text();
+			token = json.next();
+			if (key == "search") return true;
+			if (!json.skip(token)) return false;
+		}
+	}
+
+	JsonReader json;
+};
+
+struct Walker {
+	using Change = TreeDiff::Change;
+
+	Walker(QIODevice *base, QIODevice *other, qreal tolerance,
+	       const TreeDiff::Report &report, const TreeFile::Progress &progress):
+	    a(base), b(other), tolerance(tolerance), report(report), progress(progress) {}
+
+	bool fail(const QString &message)
+	{
+		if (error.isEmpty()) error = message;
+		return false;
+	}
+
+	bool tick()
+	{
+		if ((++ count % 4096 == 0) && progress &&
+		    !progress(a.json.pos(), a.json.size())) {
+			return fail("Operation canceled!");
+		}
+		return true;
+	}
+
+	//Обходим оба дерева синхронно; память ограничена глубиной
+	bool node(Token ta, Token tb, std::string &path)
+	{
+		bool ea, eb;
+		if (!a.open(ta, ea) || !b.open(tb, eb)) {
+			return fail("Invalid node!");
+		}
+		if (!ea && !eb) return true;
+		if (!ea || !eb) {
+			Change change;
+			change._kind = ea? TreeDiff::Removed: TreeDiff::Added;
+			change._path = path;
+			change._count = 0;
+			QPointF point;
+			if (!(ea? a: b).subtree(change._count, point)) {
+				return fail("Invalid node!");
+			}
+			(ea? change._from: change._to) = point;
+			report(change);
+			return tick();
+		}
+		QPointF pa, pb;
+		bool ba, bb;
+		if (!a.seek(pa, ba) || !b.seek(pb, bb)) {
+			return fail("Invalid node!");
+		}
+		bool la = ba, lb = bb;
+		for (int i = 0; i < 2; ++ i) {
+			Token na = a.element(la);
+			Token nb = b.element(lb);
+			path.push_back('0' + i);
+			bool ok = node(na, nb, path);
+			path.pop_back();
+			if (!ok) return false;
+		}
+		if ((ba && !a.close(la, pa)) || (bb && !b.close(lb, pb))) {
+			return fail("Invalid node!");
+		}
+		qreal dx = pa.x() - pb.x();
+		qreal dy = pa.y() - pb.y();
+		if (std::sqrt(dx * dx + dy * dy) > tolerance) {
+			Change change;
+			change._kind = TreeDiff::Moved;
+			change._path = path;
+			change._from = pa;
+			change._to = pb;
+			report(change);
+		}
+		return tick();
+	}
+
+	bool run()
+	{
+		Token ta, tb;
+		if (!a.search(ta) || !b.search(tb)) {
+			return fail("Invalid JSON!");
+		}
+		std::string path;
+		if (!node(ta, tb, path)) return false;
+		if (progress) progress(a.json.size(), a.json.size());
+		return true;
+	}
+
+	Side a, b;
+	qreal tolerance;
+	const TreeDiff::Report &report;
+	const TreeFile::Progress &progress;
+	QString error;
+	qint64 count = 0;
+};
+
+}
+
+bool TreeDiff::compare(QIODevice *base, QIODevice *other, qreal tolerance,
+                       const Report &report, const TreeFile::Progress &progress,
+                       QString *error)
+{
+	Walker walker(base, other, tolerance, report, progress);
+	if (!walker.run()) {
+		if (error) *error = walker.error;
+		return false;
+	}
+	return true;
+}
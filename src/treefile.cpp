@@ -0,0 +1,279 @@
+#include <treefile.hpp>
+#include <jsonreader.hpp>
+#include <QLocale>
+#include <cmath>
+
+namespace {
+
+constexpr qint64 step = 4096;
+//Предел вложенности, пока набор окружностей ещё не прочитан
+constexpr int depthLimit = 4096;
+
+struct Reader {
+	using Token = JsonReader::Token;
+
+	Reader(QIODevice *device, const TreeFile::Progress &progress):
+	    json(device), progress(progress) {}
+
+	bool fail(const QString &message)
+	{
+		if (error.isEmpty()) error = message;
+		return false;
+	}
+
+	bool tick()
+	{
+		if ((++ count % step == 0) && progress &&
+		    !progress(json.pos(), json.size())) {
+			return fail("Operation canceled!");
+		}
+		return true;
+	}
+
+	bool node(Token token, std::shared_ptr<TreeNode> &result, int index)
+	{
+		if (token == JsonReader::Null) return true;
+		if (token != JsonReader::BeginObject) {
+			return fail("Object expected!");
+		}
+		//Пустой объект обозначает отсутствующую ветвь
+		if (json.peek() == JsonReader::EndObject) {
+			json.next();
+			return true;
+		}
+		//Глубину проверяем при спуске, чтобы не переполнить стек
+		if (index >= limit) {
+			return fail("Tree is deeper than the set of circles!");
+		}
+		auto node = std::make_shared<TreeNode>();
+		node->_index = index;
+		node->_fixed = true;
+		last = std::max(last, index);
+		bool center = false;
+		for (;;) {
+			token = json.next();
+			if (token == JsonReader::EndObject) break;
+			if (token != JsonReader::String) {
+				return fail("Key expected!");
+			}
+			QByteArray key = json.text();
+			token = json.next();
+			if (key == "center") {
+				if (token != JsonReader::BeginArray ||
+				    json.next() != JsonReader::Number) {
+					return fail("Invalid center!");
+				}
+				qreal x = json.number();
+				if (json.next() != JsonReader::Number) {
+					return fail("Invalid center!");
+				}
+				qreal y = json.number();
+				if (json.next() != JsonReader::EndArray ||
+				    !std::isfinite(x) || !std::isfinite(y)) {
+					return fail("Invalid center!");
+				}
+				node->_center = QPointF(x, y);
+				center = true;
+			}
+			else
+			if (key == "exit") {
+				if (token != JsonReader::Bool) {
+					return fail("Invalid exit!");
+				}
+				node->_exit = json.boolean();
+			}
+			else
+			if (key == "branch") {
+				if (token != JsonReader::BeginArray) {
+					return fail("Invalid branch!");
+				}
+				for (int i = 0; (token = json.next()) != JsonReader::EndArray; ++ i) {
+					if (i > 1) return fail("Too many branches!");
+					if (token == JsonReader::Null) {
+						node->_empty[i] = true;
+						continue;
+					}
+					if (!this->node(token, node->_branch[i], index + 1)) {
+						return false;
+					}
+				}
+			}
+			else
+			if (!json.skip(token)) {
+				return fail("Invalid JSON!");
+			}
+		}
+		if (!center) return fail("Node without center!");
+		if (node->_exit) {
+			if (node->_branch[0] || node->_branch[1]) {
+				return fail("Exit node with branches!");
+			}
+			exits.push_back(node.get());
+		}
+		result = node;
+		return tick();
+	}
+
+	bool document(TreeDocument &doc)
+	{
+		if (json.next() != JsonReader::BeginObject) {
+			return fail("Object expected!");
+		}
+		for (;;) {
+			Token token = json.next();
+			if (token == JsonReader::EndObject) break;
+			if (token != JsonReader::String) {
+				return fail("Key expected!");
+			}
+			QByteArray key = json.text();
+			token = json.next();
+			if (key == "radius") {
+				if (token != JsonReader::BeginArray) {
+					return fail("Invalid radius!");
+				}
+				while ((token = json.next()) != JsonReader::EndArray) {
+					if (token != JsonReader::Number) {
+						return fail("Invalid radius!");
+					}
+					qreal r = json.number();
+					if (!std::isfinite(r) || (r <= 0.)) {
+						return fail("Invalid radius!");
+					}
+					doc._radius.push_back(r);
+				}
+				limit = std::min(limit, int(doc._radius.size()));
+			}
+			else
+			if (key == "search") {
+				if (!node(token, doc._root, 1)) return false;
+			}
+			else
+			if (!json.skip(token)) {
+				return fail("Invalid JSON!");
+			}
+		}
+		if (doc._radius.size() < 2) {
+			return fail("Not enough circles!");
+		}
+		if (last >= int(doc._radius.size())) {
+			return fail("Tree is deeper than the set of circles!");
+		}
+		//Узел раннего выхода ставит последнюю окружность
+		for (auto *node : exits) {
+			node->_index = int(doc._radius.size()) - 1;
+		}
+		if (progress) progress(json.size(), json.size());
+		return true;
+	}
+
+	JsonReader json;
+	const TreeFile::Progress &progress;
+	QString error;
+	qint64 count = 0;
+	int last = 0;
+	int limit = depthLimit;
+	std::vector<TreeNode*> exits;
+};
+
+struct Writer {
+	Writer(QIODevice *device, const TreeFile::Progress &progress):
+	    device(device), progress(progress) {}
+
+	static QByteArray number(qreal value)
+	{
+		return QByteArray::number(value, 'g', QLocale::FloatingPointShortest);
+	}
+
+	static qint64 size(const TreeNode *node)
+	{
+		if (!node) return 0;
+		return 1 + size(node->_branch[0].get()) +
+		           size(node->_branch[1].get());
+	}
+
+	bool flush()
+	{
+		if (device->write(buffer) != buffer.size()) return false;
+		buffer.clear();
+		return true;
+	}
+
+	bool node(const TreeNode *node)
+	{
+		//Лист раннего выхода хранится без ветвей
+		if (node->_exit) {
+			buffer += "{\"exit\":true,\"center\":[";
+		}
+		else {
+			buffer += "{\"branch\":[";
+			for (int i = 0; i < 2; ++ i) {
+				if (i) buffer += ',';
+				auto *next = node->_branch[i].get();
+				if (!next) {
+					buffer += node->_empty[i]? "null": "{}";
+					continue;
+				}
+				if (!this->node(next)) return false;
+			}
+			buffer += "],\"center\":[";
+		}
+		buffer += number(node->_center.x());
+		buffer += ',';
+		buffer += number(node->_center.y());
+		buffer += "]}";
+		if ((buffer.size() >= (1 << 16)) && !flush()) {
+			return false;
+		}
+		if ((++ count % step == 0) && progress &&
+		    !progress(count, total)) {
+			return false;
+		}
+		return true;
+	}
+
+	bool document(const TreeDocument &doc)
+	{
+		total = size(doc._root.get());
+		buffer += "{\"radius\":[";
+		for (size_t i = 0; i < doc._radius.size(); ++ i) {
+			if (i) buffer += ',';
+			buffer += number(doc._radius[i]);
+		}
+		buffer += "],\"search\":";
+		if (doc._root) {
+			if (!node(doc._root.get())) return false;
+		}
+		else {
+			buffer += "{}";
+		}
+		buffer += '}';
+		if (!flush()) return false;
+		if (progress) progress(total, total);
+		return true;
+	}
+
+	QIODevice *device;
+	const TreeFile::Progress &progress;
+	QByteArray buffer;
+	qint64 count = 0;
+	qint64 total = 0;
+};
+
+}
+
+bool TreeFile::read(QIODevice *device, TreeDocument &doc, const Progress &progress, QString *error)
+{
+	doc = TreeDocument();
+	Reader reader(device, progress);
+	if (!reader.document(doc)) {
+		if (error) *error = reader.error;
+		return false;
+	}
+	return true;
+}
+
+bool TreeFile::write(QIODevice *device, const TreeDocument &doc, const Progress &progress)
+{
+	Writer writer(device, progress);
+	return writer.document(doc);
+}
@@ -0,0 +1,203 @@
+#include <treemap.hpp>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QPainter>
+
+TreeMap::TreeMap(QWidget *parent): QWidget(parent) {
+	setMinimumWidth(160);
+	setMouseTracking(false);
+}
+
+TreeMap::~TreeMap()
+{
+}
+
+qreal TreeMap::toWidget(qreal u) const
+{
+	return (u - _left) * _zoom * width();
+}
+
+qreal TreeMap::fromWidget(qreal x) const
+{
+	return _left + x / (_zoom * width());
+}
+
+qreal TreeMap::levelY(int depth) const
+{
+	if (_levels < 2) return _margin;
+	qreal step = (height() - 2 * _margin) / (_levels - 1);
+	return _margin + depth * step;
+}
+
+void TreeMap::clamp()
+{
+	_zoom = std::max(_zoom, 1.);
+	_left = std::max(0., std::min(_left, 1. - 1. / _zoom));
+}
+
+void TreeMap::paintEvent(QPaintEvent *event)
+{
+	QPainter painter(this);
+	painter.fillRect(rect(), Qt::white);
+	if (!_scene) return;
+
+	_levels = _scene->getLevels();
+	_path = _scene->getTextPath();
+	_depth = _path.find(GraphicsScene::ANY);
+	if (_depth < 0) _depth = _path.size();
+
+	painter.setRenderHint(QPainter::Antialiasing);
+	std::string path;
+	auto root = _scene->getRoot();
+	if (!root) {
+		paintOpen(painter, path, 0., 1., true);
+		return;
+	}
+	paintNode(painter, root.get(), path, 0., 1., true);
+}
+
+bool TreeMap::hasMarks(const std::string &path) const
+{
+	auto it = _marks.lower_bound(path);
+	return (it != _marks.end()) &&
+	       !it->first.compare(0, path.size(), path);
+}
+
+void TreeMap::paintMark(QPainter &painter, const std::string &path, const QPointF &p)
+{
+	auto it = _marks.find(path);
+	if (it == _marks.end()) return;
+	QColor color = it->second == '+'? QColor(0, 160, 0):
+	               it->second == '-'? QColor(255, 0, 255):
+	                                  QColor(255, 127, 0);
+	painter.setPen(QPen(color, 2.));
+	painter.setBrush(Qt::NoBrush);
+	painter.drawEllipse(p, 7., 7.);
+}
+
+void TreeMap::paintOpen(QPainter &painter, std::string &path, qreal a, qreal b, bool current)
+{
+	qreal x1 = toWidget(a), x2 = toWidget(b);
+	if (x2 < 0 || x1 > width()) return;
+	int depth = path.size();
+	QPointF p((x1 + x2) / 2., levelY(depth));
+	painter.setPen(QPen(current? QColor(0, 0, 255): QColor(255, 0, 0), 1.5));
+	painter.setBrush(Qt::NoBrush);
+	painter.drawEllipse(p, 3., 3.);
+	paintMark(painter, path, p);
+
+	//Текущий узел может еще не входить в дерево
+	if (!current || depth >= _depth) return;
+	int ans = _path[depth] == '1';
+	qreal m = (a + b) / 2.;
+	qreal c1 = ans? m: a, c2 = ans? b: m;
+	QPointF q((toWidget(c1) + toWidget(c2)) / 2., levelY(depth + 1));
+	painter.setPen(QPen(QColor(0, 0, 255), 1.));
+	painter.drawLine(p, q);
+	path.push_back('0' + ans);
+	paintOpen(painter, path, c1, c2, true);
+	path.pop_back();
+}
+
+void TreeMap::paintNode(QPainter &painter, const TreeNode *node, std::string &path, qreal a, qreal b, bool current)
+{
+	//Отбрасываем поддеревья за пределами видимой области
+	qreal x1 = toWidget(a), x2 = toWidget(b);
+	if (x2 < 0 || x1 > width()) return;
+	int depth = path.size();
+	QPointF p((x1 + x2) / 2., levelY(depth));
+
+	//Узкие поддеревья рисуем одной полосой без обхода
+	if ((x2 - x1 < _detail) && !current) {
+		painter.fillRect(
+		    QRectF(x1, p.y(), std::max(1., x2 - x1), levelY(_levels - 1) - p.y() + 1.),
+		    hasMarks(path)? QColor(255, 127, 0): QColor(160, 160, 160)
+		);
+		return;
+	}
+
+	qreal m = (a + b) / 2.;
+	if ((depth + 1 < _levels) && !node->_exit) {
+		for (int i = 0; i < 2; ++ i) {
+			qreal c1 = i? m: a, c2 = i? b: m;
+			bool next = current && (depth < _depth) && (_path[depth] == '0' + i);
+			if (node->_empty[i] && !next) continue;
+			QPointF q((toWidget(c1) + toWidget(c2)) / 2., levelY(depth + 1));
+			painter.setPen(QPen(next? QColor(0, 0, 255): QColor(127, 127, 127), 1.));
+			painter.drawLine(p, q);
+			path.push_back('0' + i);
+			auto *child = node->_branch[i].get();
+			if (child) {
+				paintNode(painter, child, path, c1, c2, next);
+			}
+			else {
+				paintOpen(painter, path, c1, c2, next);
+			}
+			path.pop_back();
+		}
+	}
+
+	QColor color = node->_fixed? QColor(0, 0, 0): QColor(255, 0, 0);
+	qreal size = 3.;
+	if (current && depth == _depth) {
+		color = QColor(0, 0, 255);
+		size = 5.;
+	}
+	painter.setPen(Qt::NoPen);
+	painter.setBrush(color);
+	painter.drawEllipse(p, size, size);
+	paintMark(painter, path, p);
+}
+
+void TreeMap::mousePressEvent(QMouseEvent *event)
+{
+	_press = _prev = event->pos();
+	_moved = false;
+}
+
+void TreeMap::mouseMoveEvent(QMouseEvent *event)
+{
+	if (!(event->buttons() & Qt::LeftButton)) return;
+	auto off = event->pos() - _prev;
+	if ((event->pos() - _press).manhattanLength() > 3) {
+		_moved = true;
+	}
+	_prev = event->pos();
+	_left -= off.x() / (_zoom * width());
+	clamp();
+	update();
+}
+
+void TreeMap::mouseReleaseEvent(QMouseEvent *event)
+{
+	if (_moved || _levels < 1) return;
+
+	//Восстанавливаем путь по положению курсора
+	qreal step = _levels > 1? (height() - 2 * _margin) / (_levels - 1): 1.;
+	int depth = std::lround((event->pos().y() - _margin) / step);
+	depth = std::max(0, std::min(depth, _levels - 1));
+	qreal u = fromWidget(event->pos().x());
+	if (u < 0. || u >= 1.) return;
+	QString path;
+	for (int i = 0; i < depth; ++ i) {
+		u *= 2.;
+		int ans = u >= 1.;
+		path += QChar('0' + ans);
+		u -= ans;
+	}
+	emit pathClicked(path);
+}
+
+void TreeMap::wheelEvent(QWheelEvent *event)
+{
+	constexpr qreal factor = 1.25;
+
+	//Масштабируем относительно курсора
+	qreal x = event->pos().x();
+	qreal u = fromWidget(x);
+	_zoom *= (event->angleDelta().y() < 0)? (1. / factor): factor;
+	_zoom = std::min(_zoom, qreal(1 << 30));
+	_left = u - x / (_zoom * width());
+	clamp();
+	update();
+}
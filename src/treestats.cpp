@@ -0,0 +1,26 @@
+#include <treestats.hpp>
+#include <QStringList>
+
+QString TreeStats::toText() const
+{
+	QStringList depth;
+	for (auto count : _depth) depth << QString::number(count);
+	return QString("nodes: %1, fixed: %2, open: %3, unsaved: %4, memory: %5 KB\ndepth: %6")
+	       .arg(_nodes).arg(_fixed).arg(_open).arg(_pending)
+	       .arg(bytes() / 1024).arg(depth.join(' '));
+}
+
+QString TreeStats::csvHeader()
+{
+	return "nodes,fixed,unfixed,open,unsaved,bytes,depth";
+}
+
+QString TreeStats::toCsv() const
+{
+	//Гистограмма глубин занимает одну ячейку
+	QStringList depth;
+	for (auto count : _depth) depth << QString::number(count);
+	return QString("%1,%2,%3,%4,%5,%6,%7")
+	       .arg(_nodes).arg(_fixed).arg(_nodes - _fixed).arg(_open)
+	       .arg(_pending).arg(bytes()).arg(depth.join(' '));
+}
@@ -0,0 +1,124 @@
+#include <treetask.hpp>
+#include <treefile.hpp>
+#include <journal.hpp>
+#include <codegen.hpp>
+#include <trace.hpp>
+#include <QSaveFile>
+#include <QFile>
+#include <algorithm>
+
+TreeTask::TreeTask(Kind kind, const QString &fileName, QObject *parent):
+    QThread(parent), _fileName(fileName), _kind(kind) {
+}
+
+TreeTask::~TreeTask()
+{
+	requestInterruption();
+	wait();
+}
+
+bool TreeTask::progress(qint64 done, qint64 total)
+{
+	int percent = total > 0? int(100 * done / total): 0;
+	if (percent != _percent) {
+		_percent = percent;
+		emit progressChanged(percent);
+	}
+	_canceled = isInterruptionRequested();
+	return !_canceled;
+}
+
+qint64 TreeTask::read(const QString &fileName, TreeDocument &doc,
+                      const TreeFile::Progress &progress, QString *error)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) {
+		if (error) *error = file.errorString();
+		return -1;
+	}
+	if (!TreeFile::read(&file, doc, progress, error)) {
+		doc = TreeDocument();
+		return -1;
+	}
+	//Правки после последнего полного сохранения
+	return std::max<qint64>(Journal::replay(fileName, doc), 0);
+}
+
+void TreeTask::run()
+{
+	TRACE_SPAN("TreeTask::run");
+	auto progress = [this](qint64 done, qint64 total) {
+		return this->progress(done, total);
+	};
+	if (_kind == Load) {
+		_recovered = read(_fileName, _doc, progress, &_error);
+		_succeeded = _recovered >= 0;
+		if (!_succeeded) {
+			_recovered = 0;
+			return;
+		}
+		index();
+		return;
+	}
+	if (_kind == Diff) {
+		QFile base(_fileName), other(_other);
+		for (auto *file : {&base, &other}) {
+			if (!file->open(QIODevice::ReadOnly)) {
+				_error = file->errorString();
+				return;
+			}
+		}
+		_succeeded = TreeDiff::compare(&base, &other, 1.e-7,
+		[this](const TreeDiff::Change &change) {
+			_changes.push_back(change);
+		}, progress, &_error);
+		return;
+	}
+	//Файл заменяется только после успешной записи
+	QSaveFile file(_fileName);
+	if (!file.open(QIODevice::WriteOnly)) {
+		_error = file.errorString();
+		return;
+	}
+	if ((_kind == Export) || (_kind == Image)) {
+		_succeeded = ((_kind == Export)?
+		              CodeGen::write(&file, _doc, "circlegen", progress, &_error):
+		              _poster->write(&file, progress, &_error)) &&
+		             file.commit();
+		if (!_succeeded) {
+			if (_error.isEmpty()) _error = file.errorString();
+			file.cancelWriting();
+		}
+		return;
+	}
+	if (!TreeFile::write(&file, _doc, progress)) {
+		_error = _canceled?
+		         "Operation canceled!":
+		         file.errorString();
+		file.cancelWriting();
+		return;
+	}
+	_succeeded = file.commit();
+	if (!_succeeded) _error = file.errorString();
+	else
+	if (_indexing) index();
+}
+
+void TreeTask::index()
+{
+	if (!_doc._root || (_doc._radius.size() < 2) || isInterruptionRequested()) {
+		return;
+	}
+	//Разбиение хранится рядом с деревом и проверяется по отпечатку
+	QString fileName = _fileName + ".qtree";
+	auto fingerprint = QuadTree::fingerprint(_doc);
+	if (_kind == Load) {
+		_quadTree = QuadTree::load(fileName, fingerprint);
+		if (_quadTree) return;
+	}
+	Classifier classifier({{0., 0.}, _doc._radius[0]}, _doc._radius, _doc._root);
+	_quadTree = QuadTree::build(classifier);
+	_quadTree->setFingerprint(fingerprint);
+	//Открытие файла не должно ничего писать рядом с ним
+	if (_kind == Save) _quadTree->save(fileName);
+}
@@ -0,0 +1,52 @@
+#include <verifier.hpp>
+#include <algorithm>
+
+TreeNode::Status Verifier::verify(TreeNode *root) const
+{
+	if (!root) return TreeNode::Open;
+	Cell cell(_base);
+	verify(root, cell);
+	return root->_status;
+}
+
+void Verifier::verify(TreeNode *node, Cell &cell) const
+{
+	if (node->_status != TreeNode::Unknown) return;
+
+	Disk disk{node->_center, _radius.at(node->_index)};
+	if (node->_index + 1 >= int(_radius.size())) {
+		//Последняя окружность должна накрыть всю ячейку
+		cell.push(disk, false);
+		node->_uncovered = cell.area();
+		cell.pop();
+		node->_status = (node->_uncovered > 0.)?
+		                TreeNode::Failed:
+		                TreeNode::Solved;
+		return;
+	}
+	node->_status = TreeNode::Solved;
+	node->_uncovered = 0.;
+	for (int i = 0; i < 2; ++ i) {
+		cell.push(disk, i);
+		auto *next = node->_branch[i].get();
+		auto status = TreeNode::Open;
+		qreal uncovered;
+		if (next) {
+			verify(next, cell);
+			status = next->_status;
+			uncovered = next->_uncovered;
+		}
+		else
+		if (node->_empty[i] && cell.isEmpty()) {
+			//Отметке не доверяем: ячейка могла измениться после правки
+			status = TreeNode::Solved;
+			uncovered = 0.;
+		}
+		else {
+			uncovered = cell.area();
+		}
+		cell.pop();
+		node->_status = std::max(node->_status, status);
+		node->_uncovered += uncovered;
+	}
+}